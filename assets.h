@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "texture.h"
+
+// Textures by asset path, so every image is decoded once however many users it has
+//
+// start() loads everything asked for so far on a thread with its own hidden
+// context sharing objects with the window's, decoding and uploading while
+// the main thread links shaders and builds the ui. Without a shared context
+// wait() just loads them in place.
+struct asset_loader_t {
+    // Same texture_t for the same path, not loaded before wait()
+    texture_t *texture(const char *path) {
+        for (auto &t : textures)
+            if (t.first == path)
+                return t.second;
+        textures.emplace_back(path, new texture_t);
+        return textures.back().second;
+    }
+
+    int start(GLFWwindow *share) {
+        started = std::chrono::steady_clock::now();
+
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        context = glfwCreateWindow(1, 1, "", nullptr, share);
+        if (!context)
+            return glsuccess;
+
+        thread = std::thread([this]() {
+            glfwMakeContextCurrent(context);
+            load_all();
+            // Uploads have to land before another context can use them
+            glFinish();
+            glfwMakeContextCurrent(nullptr);
+        });
+
+        return glsuccess;
+    }
+
+    // Blocks until every texture is usable on the calling thread's context
+    int wait() {
+        if (thread.joinable())
+            thread.join();
+        else
+            load_all();
+
+        if (context) {
+            glfwDestroyWindow(context);
+            context = nullptr;
+        }
+
+        if (failed)
+            handle_error("Failed to load assets");
+
+        return glsuccess;
+    }
+
+    // Seconds from start() to the last texture being uploaded
+    double time = 0;
+
+    protected:
+    void load_all() {
+        for (auto &t : textures)
+            if (t.second->load(t.first.c_str()))
+                failed = true;
+        time = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+
+    std::vector<std::pair<std::string, texture_t*>> textures;
+    GLFWwindow *context = nullptr;
+    std::thread thread;
+    std::atomic<bool> failed = false;
+    std::chrono::steady_clock::time_point started;
+};
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "texture.h"
+#include "text.h"
+#include "ui_element.h"
+#include "ui_text.h"
+#include "shader_program.h"
+#include "shader.h"
+#include "circle_text.h"
+#include "headless.h"
+#include "spiral_kernel.h"
+#include "spiral_layout.h"
+#include "tests/lcg_source.h"
+
+// Times meshing, the reverse_dir fit, vertex upload and an offscreen draw
+// at a few digit counts and writes the results as JSON
+//
+//   ./bench [--sizes 1000,10000,...] [--reps n] [--instanced|--packed] [--out bench.json]
+
+namespace bench {
+    shader_t *text_vertex;
+    shader_t *text_fragment;
+    shaderProgram_t *text_program;
+    shader_t *instanced_vertex;
+    shaderProgram_t *instanced_program;
+    shader_t *packed_vertex;
+    shaderProgram_t *packed_program;
+    texture_t *text_texture;
+    ui_circle_text_t *circle_text;
+    spiral_layout_t start_layout; // the sliders before any auto-fit
+    headless_t *target;
+
+    std::vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    int reps = 5;
+    bool instanced = false;
+    bool packed = false;
+    const char *out_path = nullptr;
+
+    const int target_size = 1024;
+    const size_t append_glyphs = 1000;
+
+    struct timing_t {
+        std::vector<double> ms;
+
+        void add(double v) { ms.push_back(v); }
+
+        void write(FILE *f, const char *name) const {
+            std::vector<double> s = ms;
+            std::sort(s.begin(), s.end());
+            double sum = 0;
+            for (double v : s)
+                sum += v;
+            fprintf(f, "\"%s\": {\"min_ms\": %.4f, \"median_ms\": %.4f, \"mean_ms\": %.4f, \"runs\": %zu}",
+                    name, s.front(), s[s.size() / 2], sum / s.size(), s.size());
+        }
+    };
+
+    template<typename F>
+    double time_ms(F &&f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string json_string(const char *s) {
+        std::string out = "\"";
+        for (; s && *s; s++) {
+            if (*s == '"' || *s == '\\')
+                out += '\\';
+            if ((unsigned char)*s >= 0x20)
+                out += *s;
+        }
+        return out + "\"";
+    }
+
+    int parse_args(int argc, char **argv) {
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], "--sizes") && i + 1 < argc) {
+                sizes.clear();
+                for (char *s = argv[++i]; *s; ) {
+                    sizes.push_back(strtoull(s, &s, 10));
+                    if (*s == ',')
+                        s++;
+                    else if (*s)
+                        return 1;
+                }
+            } else if (!strcmp(argv[i], "--reps") && i + 1 < argc && (reps = atoi(argv[++i])) > 0)
+                continue;
+            else if (!strcmp(argv[i], "--instanced"))
+                instanced = true;
+            else if (!strcmp(argv[i], "--packed"))
+                packed = true;
+            else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+                out_path = argv[++i];
+            else {
+                fprintf(stderr, "Usage: %s [--sizes n,n,...] [--reps n] [--instanced|--packed] [--out file.json]\n", argv[0]);
+                return 1;
+            }
+        }
+
+        return sizes.empty();
+    }
+
+    int init() {
+        headless_init_hints();
+        if (!glfwInit())
+            handle_error("Failed to init glfw");
+
+        headless_window_hints();
+        window = glfwCreateWindow(target_size, target_size, "Pi Day 2025 bench", 0, 0);
+        if (!window)
+            handle_error("Failed to create glfw window");
+
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(0);
+
+        text_vertex = new shader_t(GL_VERTEX_SHADER);
+        text_fragment = new shader_t(GL_FRAGMENT_SHADER);
+        text_program = new shaderProgram_t(text_vertex, text_fragment);
+        instanced_vertex = new shader_t(GL_VERTEX_SHADER);
+        instanced_program = new shaderProgram_t(instanced_vertex, text_fragment);
+        packed_vertex = new shader_t(GL_VERTEX_SHADER);
+        packed_program = new shaderProgram_t(packed_vertex, text_fragment);
+        text_texture = new texture_t;
+
+        if (text_vertex->load("shaders/text_vertex.glsl") ||
+            text_fragment->load("shaders/text_fragment.glsl") ||
+            instanced_vertex->load("shaders/text_instanced_vertex.glsl") ||
+            packed_vertex->load("shaders/text_packed_vertex.glsl") ||
+            text_program->load() || instanced_program->load() || packed_program->load())
+            handle_error("Failed to compile shaders");
+
+        if (text_texture->load("assets/text.png"))
+            handle_error("Failed to load assets");
+
+        circle_text = new ui_circle_text_t(window, text_program, text_texture, {-1.0,-1.0,1.0,1.0});
+        circle_text->instanced = instanced;
+        circle_text->instance_program = instanced_program;
+        circle_text->packed = packed;
+        circle_text->packed_program = packed_program;
+        // Time the build itself, not a worker handing it over a frame later
+        circle_text->async = false;
+        circle_text->load();
+        start_layout = circle_text->layout();
+
+        target = new headless_t(target_size, target_size);
+        if (target->load([](const uint8_t *) { return (int)glsuccess; }))
+            handle_error("Failed to create offscreen framebuffer");
+
+        return glsuccess;
+    }
+
+    // Draw the whole spiral once into the offscreen target and wait for it
+    void draw() {
+        target->bind();
+        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glm::mat4 projection(1.0f);
+        instanced_program->use();
+        instanced_program->set_m4("projection", projection);
+        packed_program->use();
+        packed_program->set_m4("projection", projection);
+        text_program->use();
+        text_program->set_m4("projection", projection);
+        circle_text->render();
+        glFinish();
+    }
+
+    void run_size(FILE *f, size_t count) {
+        lcg_source_t source(count);
+        timing_t mesh_full, mesh_warm, mesh_append, fit, upload, render;
+        size_t vertex_bytes = 0;
+        // Small sizes append a tenth so there's a mesh to append to
+        size_t append = std::min(append_glyphs, count / 10);
+        int appended = 0;
+
+        for (int r = 0; r < reps; r++) {
+            // solve() directly skips the memoized fit, so every run does the full search
+            fit.add(time_ms([&] { spiral_fit_t::solve(start_layout, count); }));
+
+            // A rebuild leaves the fitted layout behind and memoizes the fit, so
+            // mesh_full starts over from the sliders every time and mesh_warm is
+            // the same rebuild again once the fit has settled
+            circle_text->reset_layout(start_layout);
+            circle_text->set_source(&source, count);
+            mesh_full.add(time_ms([&] { circle_text->mesh(); }));
+
+            circle_text->set_source(&source, count);
+            mesh_warm.add(time_ms([&] { circle_text->mesh(); }));
+
+            render.add(time_ms([&] { draw(); }));
+            vertex_bytes = circle_text->vertex_bytes();
+
+            // The last digits arriving on top of an existing mesh. Until the fit
+            // converges a reverse_dir append outgrows fit_radii and rebuilds
+            // instead, so this one runs outward, and appends counts the meshes
+            // that really appended.
+            spiral_layout_t outward = start_layout;
+            outward.reverse_dir = false;
+            circle_text->reset_layout(outward);
+            circle_text->set_source(&source, count - append);
+            circle_text->mesh();
+            circle_text->show(count);
+            size_t before = circle_text->appends;
+            mesh_append.add(time_ms([&] { circle_text->mesh(); glFinish(); }));
+            appended += circle_text->appends - before;
+
+            // A full upload of the glyph data in whichever format it's in
+            std::vector<uint8_t> data(vertex_bytes);
+            GLuint buffer;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, data.size(), nullptr, GL_DYNAMIC_DRAW);
+            glFinish();
+            upload.add(time_ms([&] {
+                glBufferSubData(GL_ARRAY_BUFFER, 0, data.size(), data.data());
+                glFinish();
+            }));
+            glDeleteBuffers(1, &buffer);
+        }
+
+        if (appended < reps)
+            fprintf(stderr, "%zu digits: %i of %i appends rebuilt instead\n", count, reps - appended, reps);
+
+        fprintf(f, "    {\"digits\": %zu, \"vertex_bytes\": %zu, \"appended\": %zu, \"appends\": %i, ", count, vertex_bytes, append, appended);
+        mesh_full.write(f, "mesh_full");
+        fprintf(f, ", ");
+        mesh_warm.write(f, "mesh_warm");
+        fprintf(f, ", ");
+        mesh_append.write(f, "mesh_append");
+        fprintf(f, ", ");
+        fit.write(f, "fit");
+        fprintf(f, ", ");
+        upload.write(f, "upload");
+        fprintf(f, ", ");
+        render.write(f, "draw");
+        fprintf(f, "}");
+
+        fprintf(stderr, "%zu digits done\n", count);
+    }
+
+    int run() {
+        FILE *f = out_path ? fopen(out_path, "w") : stdout;
+        if (!f)
+            handle_error("Failed to open output file");
+
+        fprintf(f, "{\n  \"renderer\": %s,\n  \"version\": %s,\n",
+                json_string((const char*)glGetString(GL_RENDERER)).c_str(), json_string((const char*)glGetString(GL_VERSION)).c_str());
+        fprintf(f, "  \"kernel\": %s,\n  \"format\": \"%s\",\n  \"append_glyphs\": %zu,\n  \"target\": %i,\n  \"results\": [\n",
+                json_string(spiral_kernel::best().name).c_str(), instanced ? "instanced" : packed ? "packed" : "vertices", append_glyphs, target_size);
+
+        for (size_t i = 0; i < sizes.size(); i++) {
+            run_size(f, sizes[i]);
+            fprintf(f, i + 1 < sizes.size() ? ",\n" : "\n");
+        }
+
+        fprintf(f, "  ]\n}\n");
+
+        if (f != stdout && fclose(f))
+            handle_error("Failed to write output file");
+
+        return glsuccess;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (bench::parse_args(argc, argv))
+        return 1;
+
+    if (bench::init() || bench::run())
+        handle_error("Benchmark failed");
+
+    safe_exit(0);
+}
+
+void handle_signal(int signal) {
+    fprintf(stderr, "Signal caught %i\n", signal);
+    safe_exit(1);
+}
+
+void reset() {
+
+}
+
+void destroy() {
+    glfwTerminate();
+}
+
+void safe_exit(int errcode) {
+    destroy();
+    exit(errcode);
+}
+
+void handle_error(const char *errstr, int errcode) {
+    fprintf(stderr, "Error: %s\n", errstr);
+    safe_exit(errcode);
+}
+
+void hint_exit() {
+    glfwSetWindowShouldClose(window, 1);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Zoom and pan on top of perspective_matrix
+//
+// Works in the text shader's screen space (y up). perspective_matrix is a
+// plain scale, so going back from NDC needs no matrix inverse.
+struct camera_t {
+    static constexpr float min_zoom = 0.25;
+    static constexpr float max_zoom = 10000;
+
+    glm::vec2 pan = glm::vec2(0.0f); // screen space point in the middle of the view
+    float zoom = 1;
+
+    glm::mat4 matrix() const {
+        glm::mat4 m = glm::scale(glm::mat4(1.0f), glm::vec3(zoom, zoom, 1.0f));
+        return glm::translate(m, glm::vec3(-pan[0], -pan[1], 0.0f));
+    }
+
+    // Screen space point under ndc
+    glm::vec2 unproject(const glm::mat4 &base, glm::vec2 ndc) const {
+        return glm::vec2(ndc[0] / (base[0][0] * zoom), ndc[1] / (base[1][1] * zoom)) + pan;
+    }
+
+    // Zoom by factor keeping the point under ndc in place
+    void zoom_at(const glm::mat4 &base, glm::vec2 ndc, float factor) {
+        glm::vec2 before = unproject(base, ndc);
+        zoom = std::clamp(zoom * factor, min_zoom, max_zoom);
+        pan += before - unproject(base, ndc);
+    }
+
+    void drag(const glm::mat4 &base, glm::vec2 from, glm::vec2 to) {
+        pan += unproject(base, from) - unproject(base, to);
+    }
+
+    // Visible rect as min x, min y, max x, max y in vertex coords (y down)
+    glm::vec4 view(const glm::mat4 &base) const {
+        glm::vec2 lo = unproject(base, glm::vec2(-1.0f, -1.0f));
+        glm::vec2 hi = unproject(base, glm::vec2(1.0f, 1.0f));
+        return glm::vec4(std::min(lo[0], hi[0]), std::min(-lo[1], -hi[1]), std::max(lo[0], hi[0]), std::max(-lo[1], -hi[1]));
+    }
+};
@@ -0,0 +1,992 @@
+#pragma once
+
+#include <mutex>
+
+#include "common.h"
+#include "text.h"
+#include "ui_text.h"
+#include "shader_program.h"
+#include "digit_source.h"
+#include "glyph_instance.h"
+#include "lod.h"
+#include "mesh_worker.h"
+#include "packed_vertex.h"
+#include "profile.h"
+#include "spiral_kernel.h"
+#include "spiral_layout.h"
+
+struct ui_circle_text_t : public ui_text_t {
+    ui_circle_text_t(GLFWwindow *window, shaderProgram_t *program, texture_t *texture, glm::vec4 xywh)
+    :ui_text_t(window, program, texture, xywh) {
+        //base_chars = 150.0;
+        base_chars = D_PI / 0.024;
+        base_dist = D_PI / base_chars;
+        base_center_dist = 0.178;
+        base_angle = 0;
+        char_scale = 1.0;
+        reverse_dir = true;
+        radii_scale_1 = 0.483;
+        radii_scale_2 = 1.8;
+        modified = true;
+    }
+
+    void calc() {
+        base_dist = D_PI / base_chars;
+        //base_angle = atan(base_dist / base_center_dist);
+        modified = true;
+    }
+
+    void add_char(const char ch) {
+        string_buffer += ch;
+        string_change();
+    }
+
+    // Show the first count characters of src instead of string_buffer
+    void set_source(digit_source_t *src, size_t count) {
+        source = src;
+        source_count = count;
+        meshed_count = 0;
+        replaced = true;
+        glyph_overflow = false;
+        modified = true;
+    }
+
+    // Shadows ui_text_t's, a longer string isn't an append of the old one
+    void set_string(const std::string &str) {
+        ui_text_t::set_string(str);
+        meshed_count = 0;
+        replaced = true;
+        glyph_overflow = false;
+        modified = true;
+    }
+
+    // Wait out a build in flight and stop the worker, before the source goes away
+    void stop_worker() {
+        worker.reset();
+    }
+
+    void show(size_t count) {
+        source_count = count;
+        modified = true;
+    }
+
+    // Size of the glyph data on the GPU in the format it was meshed in
+    size_t vertex_bytes() const {
+        if (meshed_instanced)
+            return meshed_count * sizeof(glyph_instance_t);
+        return meshed_count * (meshed_packed ? 4 * sizeof(packed_vertex_t) : 6 * sizeof(text_t));
+    }
+
+    // The glyph data itself, read back for tests
+    std::vector<uint8_t> read_back() const {
+        std::vector<uint8_t> out(vertex_bytes());
+        glBindBuffer(GL_ARRAY_BUFFER, meshed_instanced ? instance_vbo : meshed_packed ? packed_vbo : vbo);
+        glGetBufferSubData(GL_ARRAY_BUFFER, 0, out.size(), out.data());
+        return out;
+    }
+
+    spiral_layout_t layout() const {
+        return {base_dist, base_center_dist, base_angle, char_scale, radii_scale_1, radii_scale_2, reverse_dir};
+    }
+
+    // Back to l with nothing memoized, the next rebuild fits from scratch
+    void reset_layout(const spiral_layout_t &l) {
+        std::lock_guard<std::mutex> lock(fit_lock);
+        fit.cache.clear();
+        set_layout(l);
+        modified = true;
+    }
+
+    size_t glyph_count() const {
+        return source ? std::min(source_count, source->size()) : string_buffer.size();
+    }
+
+    char glyph(size_t i) const {
+        return source ? source->at(i) : string_buffer[i];
+    }
+
+    float base_chars;
+    float base_dist;
+    float base_center_dist;
+    float base_angle;
+    float char_scale;
+    bool reverse_dir;
+    float radii_scale_1;
+    float radii_scale_2;
+
+    // Append new characters to the existing mesh instead of rebuilding it
+    bool incremental = true;
+    size_t appends = 0; // mesh() calls that only appended
+
+    // One glyph_instance_t per character drawn with instance_program, quads
+    // when there are more distinct characters than the shader's glyph table holds
+    bool instanced = false;
+    shaderProgram_t *instance_program = nullptr;
+
+    // Quantized packed_vertex_t quads drawn with packed_program instead of text_t, vertex path only
+    bool packed = false;
+    shaderProgram_t *packed_program = nullptr;
+
+    // Full rebuilds of at least async_glyphs characters run on a worker thread
+    bool async = true;
+    size_t async_glyphs = 4096;
+
+    // render() only draws chunks of chunk_glyphs characters whose bounds meet view
+    static constexpr size_t chunk_glyphs = 256;
+    glm::vec4 view = glm::vec4(-1e30f, -1e30f, 1e30f, 1e30f); // min x, min y, max x, max y in vertex coords
+
+    // Glyph size in pixels below which chunks turn into dots or density, see lod.h
+    float pixel_scale = 0; // pixels per vertex coord unit, 0 always draws quads
+    float lod_quad_px = 3.0;
+    float lod_dot_px = 0.5;
+    shaderProgram_t *dot_program = nullptr;
+    shaderProgram_t *density_program = nullptr;
+
+    protected:
+    // Verticies of each distinct character relative to its center, for the instanced path
+    struct glyph_table_t {
+        static constexpr int max_chars = 256;
+
+        std::string chars;
+        float corners[max_chars * 12]; // 6 (x, y) per slot, spiral_kernel layout
+        glm::vec4 tex[max_chars * 6];
+    };
+
+    // Everything a full rebuild needs, safe to build off the render thread
+    struct mesh_job_t {
+        spiral_layout_t layout;
+        size_t count;
+        bool instanced;
+        const digit_source_t *source;
+        std::string chars; // string_buffer when there is no source
+        uint32_t serial;
+    };
+
+    struct mesh_result_t {
+        spiral_layout_t input;
+        spiral_layout_t layout; // after the reverse_dir auto-fit
+        size_t count;
+        bool instanced;
+        float tail_angle;
+        std::vector<text_t> verticies;
+        std::vector<glyph_instance_t> instances;
+        lod::index_t lod;
+        glyph_table_t table;
+        uint32_t serial;
+    };
+
+    void set_layout(const spiral_layout_t &l) {
+        base_dist = l.base_dist;
+        base_center_dist = l.base_center_dist;
+        base_angle = l.base_angle;
+        char_scale = l.char_scale;
+        radii_scale_1 = l.radii_scale_1;
+        radii_scale_2 = l.radii_scale_2;
+        reverse_dir = l.reverse_dir;
+    }
+
+    digit_source_t *source = nullptr;
+    size_t source_count = 0;
+
+    spiral_fit_t fit;
+    std::mutex fit_lock;
+
+    spiral_layout_t meshed_layout;
+    size_t meshed_count = 0;
+    bool meshed_instanced = false;
+    bool glyph_overflow = false; // the last build had too many distinct characters to instance
+    bool meshed_packed = false;
+    glm::vec4 packed_box = glm::vec4(0.0f); // min x, min y, max x, max y packed positions are fractions of
+    float tail_angle = 0; // angle the next appended character goes at
+    glyph_table_t table;
+    lod::index_t lod; // chunk bounds, the dots only until they are uploaded
+
+    GLuint dot_vao = 0, dot_vbo = 0;
+    size_t dot_capacity = 0;
+    GLuint density_texture = 0;
+    bool density_dirty = false;
+    bool atlas_mipmapped = false;
+
+    std::vector<GLint> draw_first, dot_first;
+    std::vector<GLsizei> draw_count, dot_count;
+    std::vector<glm::vec2> density_bands;
+
+    size_t vbo_capacity = 0; // in verticies
+    GLuint back_vao = 0, back_vbo = 0;
+    size_t back_capacity = 0;
+
+    GLuint packed_vao = 0, packed_vbo = 0;
+    size_t packed_capacity = 0;
+    GLuint packed_back_vao = 0, packed_back_vbo = 0;
+    size_t packed_back_capacity = 0;
+    std::vector<packed_vertex_t> packed_scratch;
+
+    GLuint instance_vao = 0, instance_vbo = 0;
+    size_t instance_capacity = 0;
+    size_t instance_count = 0;
+    GLuint instance_back_vao = 0, instance_back_vbo = 0;
+    size_t instance_back_capacity = 0;
+
+    uint32_t submitted_serial = 0;
+    uint32_t applied_serial = 0;
+    bool replaced = false; // the characters changed since the last submit, not just grew
+    spiral_layout_t submitted_layout;
+    bool submitted_instanced = false;
+    std::unique_ptr<mesh_worker_t<mesh_job_t, mesh_result_t>> worker;
+
+    // Instance of ch at angle for the instanced path
+    void mesh_char(const char ch, float angle, const spiral_layout_t &l, glyph_table_t &t, glyph_instance_t *out) {
+        out->angle = angle;
+        out->radii = l.radii_at(angle);
+        out->scale = sqrt(2.0f) * l.char_scale * l.second_scale_at(angle);
+        uint32_t slot = glyph_index(ch, t);
+        out->glyph = slot;
+    }
+
+    // Place count characters from angle, returns the angle after the last one
+    template<typename F>
+    float mesh_chars(F &&char_at, size_t count, const spiral_layout_t &l, float angle, float dir, glyph_table_t &t, glyph_instance_t *out) {
+        for (size_t i = 0; i < count; i++) {
+            mesh_char(char_at(i), angle, l, t, &out[i]);
+            angle += l.step_at(angle) * dir;
+        }
+        return angle;
+    }
+
+    // Corners and texture coords of already placed glyphs, 6 verticies each
+    static void transform(const spiral_kernel::batch_t &b, const glyph_table_t &t, glm::vec2 center_pos, text_t *out) {
+        static_assert(sizeof(text_t) % sizeof(float) == 0);
+        constexpr size_t stride = sizeof(text_t) / sizeof(float);
+
+        spiral_kernel::best().fn(b, t.corners, center_pos[0], center_pos[1], (float*)out, stride);
+
+        for (size_t i = 0; i < b.count; i++)
+            for (int k = 0; k < 6; k++)
+                memcpy((char*)&out[i * 6 + k] + sizeof(glm::vec2), &t.tex[b.glyph[i] * 6 + k], sizeof(glm::vec4));
+    }
+
+    // The walk along the spiral is sequential, the 6 corners of each glyph go through spiral_kernel in batches
+    template<typename F>
+    float mesh_chars(F &&char_at, size_t count, const spiral_layout_t &l, float angle, float dir, glyph_table_t &t, text_t *out) {
+        constexpr size_t batch = 4096;
+
+        std::vector<float> angles(batch), radii(batch), scales(batch);
+        std::vector<uint32_t> slots(batch);
+
+        glm::vec2 center_pos = (glm::vec2(XYWH) + glm::vec2(XYWH[2], XYWH[3])) * 0.5f;
+
+        for (size_t first = 0; first < count; first += batch) {
+            size_t n = std::min(batch, count - first);
+
+            for (size_t i = 0; i < n; i++) {
+                slots[i] = glyph_index(char_at(first + i), t);
+                angles[i] = angle;
+                radii[i] = l.radii_at(angle);
+                scales[i] = sqrt(2.0f) * l.char_scale * l.second_scale_at(angle);
+                angle += l.step_at(angle) * dir;
+            }
+
+            transform({angles.data(), radii.data(), scales.data(), slots.data(), n}, t, center_pos, &out[first * 6]);
+        }
+
+        return angle;
+    }
+
+    template<typename T>
+    static constexpr size_t per_glyph = std::is_same_v<T, text_t> ? 6 : 1;
+
+    // Furthest any corner in the table gets from its glyph center at scale 1
+    static float reach(const glyph_table_t &t) {
+        float r = 0;
+        for (size_t i = 0; i < t.chars.size() * 6; i++)
+            r = std::max(r, glm::length(glm::vec2(t.corners[i * 2], t.corners[i * 2 + 1])));
+        return r;
+    }
+
+    glm::vec4 glyph_bounds(const text_t *v, float r) const {
+        glm::vec2 lo(1e30f), hi(-1e30f);
+        for (int k = 0; k < 6; k++) {
+            glm::vec2 pos;
+            memcpy(&pos[0], &v[k], sizeof(pos));
+            lo = glm::min(lo, pos);
+            hi = glm::max(hi, pos);
+        }
+        return glm::vec4(lo[0], lo[1], hi[0], hi[1]);
+    }
+
+    glm::vec4 glyph_bounds(const glyph_instance_t *g, float r) const {
+        glm::vec2 center_pos = (glm::vec2(XYWH) + glm::vec2(XYWH[2], XYWH[3])) * 0.5f;
+        glm::vec2 pos = glm::vec2(g->radii * sin(g->angle), -g->radii * cos(g->angle)) + center_pos;
+        float e = g->scale * r;
+        return glm::vec4(pos[0] - e, pos[1] - e, pos[0] + e, pos[1] + e);
+    }
+
+    // Chunk bounds, dots and density of characters [first, first + count), data starts at first
+    template<typename T, typename F>
+    void index(const T *data, F &&char_at, size_t first, size_t count, const glyph_table_t &t, lod::index_t &out) const {
+        out.chunks.resize((first + count + chunk_glyphs - 1) / chunk_glyphs);
+        out.dots.resize(count);
+
+        float r = reach(t);
+        glm::vec2 center_pos = (glm::vec2(XYWH) + glm::vec2(XYWH[2], XYWH[3])) * 0.5f;
+
+        for (size_t i = 0; i < count; i++) {
+            glm::vec4 b = glyph_bounds(&data[i * per_glyph<T>], r);
+            glm::vec2 pos((b[0] + b[2]) * 0.5f, (b[1] + b[3]) * 0.5f);
+            out.chunks[(first + i) / chunk_glyphs].add(b, glm::length(pos - center_pos));
+
+            char ch = char_at(i);
+            out.dots[i] = {pos, b[2] - b[0], ch >= '0' && ch <= '9' ? float(ch - '0') : -1.0f};
+        }
+
+        // A fresh index sizes the grid to the spiral with room for appends
+        if (first == 0) {
+            float half = 0;
+            for (auto &c : out.chunks)
+                for (int k = 0; k < 4; k++)
+                    half = std::max(half, std::abs(c.box[k] - center_pos[k & 1]));
+            half = std::max(half * 1.25f, 1e-3f);
+            out.grid.reset(glm::vec4(center_pos[0] - half, center_pos[1] - half, center_pos[0] + half, center_pos[1] + half));
+        }
+
+        for (auto &d : out.dots)
+            out.grid.add(d);
+    }
+
+    void upload_dots(size_t first) {
+        upload(dot_vao, dot_vbo, dot_capacity, lod.dots.data(), first, lod.dots.size());
+        lod.dots.clear();
+        lod.dots.shrink_to_fit();
+        density_dirty = true;
+    }
+
+    // Table slot of ch, filled in the first time ch shows up
+    uint32_t glyph_index(const char ch, glyph_table_t &t) {
+        size_t i = t.chars.find(ch);
+        if (i != std::string::npos)
+            return i;
+        if (t.chars.size() >= glyph_table_t::max_chars)
+            return 0;
+
+        i = t.chars.size();
+        t.chars += ch;
+
+        glm::vec4 scr, tex;
+        get_parameters()->calculate(ch, 0, 0, XYWH, scr, tex);
+
+        text_t tmp[6];
+        unsigned int cnt = 0;
+        add_rect(&tmp[0], cnt, scr, tex);
+
+        // text_t is the vec2 position followed by the vec4 texture of text_vertex.glsl
+        static_assert(sizeof(text_t) == sizeof(glm::vec2) + sizeof(glm::vec4));
+
+        glm::vec2 ch_pos = glm::vec2(scr) + (glm::vec2(scr[2], scr[3]) * 0.5f);
+        for (int k = 0; k < 6; k++) {
+            glm::vec2 corner = tmp[k].coords() - ch_pos;
+            t.corners[i * 12 + k * 2] = corner[0];
+            t.corners[i * 12 + k * 2 + 1] = corner[1];
+            memcpy(&t.tex[i * 6 + k], (char*)&tmp[k] + sizeof(glm::vec2), sizeof(glm::vec4));
+        }
+
+        return i;
+    }
+
+    // Grow a buffer geometrically to hold count elements, keeping the first keep
+    template<typename T>
+    static void reserve(GLuint &vao, GLuint &buffer, size_t &capacity, size_t count, size_t keep) {
+        if (count <= capacity)
+            return;
+
+        size_t grown_capacity = std::max(std::max(capacity * 2, count), size_t(6 * 1024));
+
+        GLuint grown;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, grown_capacity * sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+
+        if (keep > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, keep * sizeof(T));
+        }
+
+        if (buffer)
+            glDeleteBuffers(1, &buffer);
+        buffer = grown;
+        capacity = grown_capacity;
+
+        if (!vao)
+            glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        T().set_attrib_pointers();
+    }
+
+    template<typename T>
+    static void upload(GLuint &vao, GLuint &buffer, size_t &capacity, const T *data, size_t first, size_t count) {
+        profile::scope_t scope("upload");
+        profile::count("bytes uploaded", count * sizeof * data);
+        reserve<T>(vao, buffer, capacity, first + count, first);
+
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferSubData(GL_ARRAY_BUFFER, first * sizeof * data, count * sizeof * data, data);
+    }
+
+    void upload(const text_t *data, size_t first, size_t count) {
+        if (!meshed_packed) {
+            upload(vao, vbo, vbo_capacity, data, first, count);
+            return;
+        }
+
+        packed_scratch.resize(count / 6 * 4);
+        packed_vertex_t::pack(data, count / 6, packed_box, packed_scratch.data());
+        upload(packed_vao, packed_vbo, packed_capacity, packed_scratch.data(), first / 6 * 4, packed_scratch.size());
+    }
+
+    void upload(const glyph_instance_t *data, size_t first, size_t count) {
+        upload(instance_vao, instance_vbo, instance_capacity, data, first, count);
+    }
+
+    // Fill the back buffers and swap them in, the front one draws until then
+    void upload_swap(const std::vector<text_t> &data) {
+        if (meshed_packed) {
+            packed_scratch.resize(data.size() / 6 * 4);
+            packed_vertex_t::pack(data.data(), data.size() / 6, packed_box, packed_scratch.data());
+            upload(packed_back_vao, packed_back_vbo, packed_back_capacity, packed_scratch.data(), 0, packed_scratch.size());
+            std::swap(packed_vao, packed_back_vao);
+            std::swap(packed_vbo, packed_back_vbo);
+            std::swap(packed_capacity, packed_back_capacity);
+            packed_scratch.clear();
+            packed_scratch.shrink_to_fit();
+            return;
+        }
+
+        upload(back_vao, back_vbo, back_capacity, data.data(), 0, data.size());
+        std::swap(vao, back_vao);
+        std::swap(vbo, back_vbo);
+        std::swap(vbo_capacity, back_capacity);
+    }
+
+    void upload_swap(const std::vector<glyph_instance_t> &data) {
+        upload(instance_back_vao, instance_back_vbo, instance_back_capacity, data.data(), 0, data.size());
+        std::swap(instance_vao, instance_back_vao);
+        std::swap(instance_vbo, instance_back_vbo);
+        std::swap(instance_capacity, instance_back_capacity);
+    }
+
+    // render() draws the visible chunks itself, exports go through the base render
+    void set_counts() {
+        currentX = meshed_count;
+        vertexCount = exporting && !meshed_instanced ? meshed_count * 6 : 0;
+        instance_count = meshed_instanced ? meshed_count : 0;
+    }
+
+    // Whether the next mesh should be instanced
+    bool instancing() const {
+        return instanced && !glyph_overflow;
+    }
+
+    mesh_job_t snapshot() {
+        mesh_job_t job;
+        job.layout = layout();
+        job.count = glyph_count();
+        job.instanced = instancing();
+        job.source = source;
+        if (!source)
+            job.chars = string_buffer;
+        job.serial = ++submitted_serial;
+        return job;
+    }
+
+    // Character i of a walk over job
+    static auto walk_chars(const mesh_job_t &job) {
+        return [&job](size_t i) {
+            return job.source ? job.source->at(i) : job.chars[i];
+        };
+    }
+
+    // Walk job.count characters from angle, returns the angle after the walk
+    template<typename T>
+    float walk(const mesh_job_t &job, const spiral_layout_t &l, float angle, glyph_table_t &t, std::vector<T> &out) {
+        size_t count = job.count;
+        out.resize(count * per_glyph<T>);
+
+        if (job.source)
+            job.source->will_read(0, count);
+
+        return mesh_chars(walk_chars(job), count, l, angle, 1, t, out.data());
+    }
+
+    // Full layout of a snapshot, runs on the worker for large counts
+    mesh_result_t build(const mesh_job_t &job) {
+        profile::scope_t scope("build");
+        mesh_result_t res;
+        res.input = job.layout;
+        res.count = job.count;
+        res.instanced = job.instanced;
+        res.serial = job.serial;
+
+        spiral_layout_t l = job.layout;
+        float angle = l.base_angle;
+
+        // reverse_dir fits the layout so the newest character lands inside fit_radii.
+        // The walk still goes outward from the fit's start with the same steps the
+        // fit took, so the newest character sits at its end angle and appends
+        // continue exactly where a rebuild with more characters would put them.
+        if (l.reverse_dir) {
+            std::lock_guard<std::mutex> lock(fit_lock);
+            auto f = fit.fit(l, job.count);
+            l = f.layout;
+            angle = f.start;
+        }
+
+        res.layout = l;
+
+        if (job.instanced) {
+            res.tail_angle = walk(job, l, angle, res.table, res.instances);
+
+            // The shader only has room for max_glyphs, the rest would draw as slot 0
+            if (res.table.chars.size() > glyph_instance_t::max_glyphs) {
+                res.instanced = false;
+                res.instances = {};
+                res.table.chars.clear();
+            }
+        }
+
+        if (res.instanced) {
+            index(res.instances.data(), walk_chars(job), 0, job.count, res.table, res.lod);
+        } else {
+            res.tail_angle = walk(job, l, angle, res.table, res.verticies);
+            index(res.verticies.data(), walk_chars(job), 0, job.count, res.table, res.lod);
+        }
+
+        return res;
+    }
+
+    void apply(mesh_result_t &res) {
+        // Packing needs add_rect's quad and the box the fresh index put around the spiral
+        meshed_packed = packed && !res.instanced && packed_program && !res.table.chars.empty() &&
+            packed_vertex_t::set_pattern(res.table.corners);
+        packed_box = res.lod.grid.rect;
+
+        if (res.instanced)
+            upload_swap(res.instances);
+        else
+            upload_swap(res.verticies);
+
+        table = res.table;
+        lod = std::move(res.lod);
+        upload_dots(0);
+        meshed_layout = res.layout;
+        meshed_count = res.count;
+        meshed_instanced = res.instanced;
+        glyph_overflow = res.table.chars.size() > glyph_instance_t::max_glyphs;
+        tail_angle = res.tail_angle;
+        applied_serial = res.serial;
+
+        // Sliders keep what the auto-fit settled on unless they moved since
+        if (layout() == res.input)
+            set_layout(res.layout);
+
+        set_counts();
+    }
+
+    // Mesh only the characters appended since the last mesh, continuing from tail_angle
+    template<typename T>
+    bool append() {
+        profile::scope_t scope("append");
+        size_t count = glyph_count() - meshed_count;
+        T *buffer = new T[count * per_glyph<T>];
+
+        if (source)
+            source->will_read(meshed_count, count);
+
+        auto char_at = [this](size_t i) { return glyph(meshed_count + i); };
+        float angle = mesh_chars(char_at, count, meshed_layout, tail_angle, 1, table, buffer);
+
+        // A new character past the shader's glyph table, the rebuild falls back to quads
+        if constexpr (std::is_same_v<T, glyph_instance_t>) {
+            if (table.chars.size() > glyph_instance_t::max_glyphs) {
+                delete [] buffer;
+                return false;
+            }
+        }
+
+        // The auto-fit has to shrink the layout again, the whole spiral moves
+        if (reverse_dir && !spiral_fit_t::converged(meshed_layout) && meshed_layout.radii_at(angle) >= spiral_fit_t::fit_radii) {
+            delete [] buffer;
+            return false;
+        }
+
+        // Packed positions can't reach past packed_box, a rebuild picks a bigger one
+        if constexpr (std::is_same_v<T, text_t>) {
+            if (meshed_packed && !packed_vertex_t::inside(buffer, count * 6, packed_box)) {
+                delete [] buffer;
+                return false;
+            }
+        }
+
+        upload(buffer, meshed_count * per_glyph<T>, count * per_glyph<T>);
+        index(buffer, char_at, meshed_count, count, table, lod);
+        upload_dots(meshed_count);
+
+        delete [] buffer;
+
+        meshed_count += count;
+        tail_angle = angle;
+        set_counts();
+
+        return true;
+    }
+
+    public:
+    // Public so bench.cpp can time it on its own
+    bool mesh() override {
+        profile::scope_t scope("mesh");
+        last_used = get_parameters();
+
+        // render_placed() owns the buffer until the export is over
+        if (exporting)
+            return glsuccess;
+
+        mesh_result_t res;
+        if (worker && worker->poll(res) && res.serial > applied_serial) {
+            apply(res);
+            if (layout() != meshed_layout || instancing() != meshed_instanced)
+                modified = true;
+        }
+
+        // Switching formats needs everything in the new one
+        bool packing = packed && !instanced && packed_program;
+        if (meshed_count > 0 && packing != meshed_packed)
+            modified = true;
+
+        // Sources grow on their own
+        if (source && glyph_count() != meshed_count)
+            modified = true;
+
+        if (glyph_count() < 1) {
+            meshed_count = 0;
+            set_counts();
+            currentY = 0;
+            modified = false;
+            return glsuccess;
+        }
+
+        if (!modified)
+            return glsuccess;
+
+        bool busy = applied_serial != submitted_serial;
+
+        // Slider changes and shrinking or replaced strings need the full layout
+        bool can_append = incremental && !busy && !replaced && meshed_count > 0 && instancing() == meshed_instanced && packing == meshed_packed &&
+            glyph_count() > meshed_count && layout() == meshed_layout;
+
+        if (can_append && (meshed_instanced ? append<glyph_instance_t>() : append<text_t>())) {
+            appends++;
+            modified = false;
+            return glsuccess;
+        }
+
+        // Appends wait for the rebuild in flight, new slider values or characters replace it
+        if (busy && !replaced && layout() == submitted_layout && instancing() == submitted_instanced)
+            return glsuccess;
+        replaced = false;
+
+        if (async && glyph_count() >= async_glyphs) {
+            if (!worker)
+                worker = std::make_unique<mesh_worker_t<mesh_job_t, mesh_result_t>>(
+                    [this](const mesh_job_t &job) { return build(job); });
+
+            submitted_layout = layout();
+            submitted_instanced = instancing();
+            worker->submit(snapshot());
+        } else {
+            mesh_job_t job = snapshot();
+            mesh_result_t res = build(job);
+            apply(res);
+        }
+
+        modified = false;
+
+        return glsuccess;
+    }
+
+    protected:
+    static void add_run(std::vector<GLint> &firsts, std::vector<GLsizei> &counts, GLint first, GLsizei count) {
+        if (!counts.empty() && firsts.back() + counts.back() == first)
+            counts.back() += count;
+        else {
+            firsts.push_back(first);
+            counts.push_back(count);
+        }
+    }
+
+    // Merge the visible chunks into runs of characters per level, density into radii bands
+    void visible_runs() {
+        draw_first.clear();
+        draw_count.clear();
+        dot_first.clear();
+        dot_count.clear();
+        density_bands.clear();
+
+        bool lod_ready = pixel_scale > 0 && dot_program && density_program;
+
+        size_t n = std::min(lod.chunks.size(), (meshed_count + chunk_glyphs - 1) / chunk_glyphs);
+        for (size_t c = 0; c < n; c++) {
+            const lod::chunk_t &ch = lod.chunks[c];
+            const glm::vec4 &b = ch.box;
+            if (b[2] < view[0] || b[0] > view[2] || b[3] < view[1] || b[1] > view[3])
+                continue;
+
+            GLint first = c * chunk_glyphs;
+            GLsizei count = std::min(chunk_glyphs, meshed_count - first);
+
+            lod::level_t level = lod_ready ? lod::pick(ch.size * pixel_scale, lod_quad_px, lod_dot_px) : lod::quads;
+            if (level == lod::quads)
+                add_run(draw_first, draw_count, first, count);
+            else if (level == lod::dots)
+                add_run(dot_first, dot_count, first, count);
+            else {
+                glm::vec2 band(ch.radii_min - ch.size * 0.5f, ch.radii_max + ch.size * 0.5f);
+                if (!density_bands.empty() && band[0] <= density_bands.back()[1])
+                    density_bands.back() = glm::vec2(std::min(band[0], density_bands.back()[0]), std::max(band[1], density_bands.back()[1]));
+                else
+                    density_bands.push_back(band);
+            }
+        }
+    }
+
+    // Glyph quads are minified a lot on the outer spiral
+    void mipmap_atlas() {
+        GLint texture;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+        if (!texture)
+            return;
+
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        // Deeper levels would bleed neighbouring glyphs together
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 3);
+        atlas_mipmapped = true;
+    }
+
+    // Glyph runs split so each draw's indices stay in 16 bits, one draw call for all of them
+    void render_packed() {
+        if (!packed_program)
+            return;
+
+        packed_program->use();
+
+        GLint program;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glm::vec4 box(packed_box[0], packed_box[1], packed_box[2] - packed_box[0], packed_box[3] - packed_box[1]);
+        glUniform4fv(glGetUniformLocation(program, "box"), 1, &box[0]);
+
+        std::vector<GLsizei> counts;
+        std::vector<const void*> offsets;
+        std::vector<GLint> bases;
+        for (size_t i = 0; i < draw_count.size(); i++) {
+            for (GLsizei g = 0; g < draw_count[i]; g += packed_vertex_t::max_quads) {
+                counts.push_back(std::min<GLsizei>(packed_vertex_t::max_quads, draw_count[i] - g) * 6);
+                offsets.push_back(nullptr);
+                bases.push_back((draw_first[i] + g) * 4);
+            }
+        }
+
+        glBindVertexArray(packed_vao);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_SHORT, offsets.data(), counts.size(), bases.data());
+    }
+
+    void render_quads() {
+        if (draw_count.empty())
+            return;
+
+        size_t glyphs = 0;
+        for (GLsizei c : draw_count)
+            glyphs += c;
+        profile::count("vertices", glyphs * (meshed_packed ? 4 : 6));
+
+        if (meshed_packed) {
+            render_packed();
+            return;
+        }
+
+        if (!meshed_instanced) {
+            for (size_t i = 0; i < draw_count.size(); i++) {
+                draw_first[i] *= 6;
+                draw_count[i] *= 6;
+            }
+            glBindVertexArray(vao);
+            glMultiDrawArrays(GL_TRIANGLES, draw_first.data(), draw_count.data(), draw_count.size());
+            return;
+        }
+
+        if (!instance_program)
+            return;
+
+        instance_program->use();
+
+        GLint program;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glm::vec2 center_pos = (glm::vec2(XYWH) + glm::vec2(XYWH[2], XYWH[3])) * 0.5f;
+        glUniform2fv(glGetUniformLocation(program, "center"), 1, &center_pos[0]);
+        int slots = std::min<int>(table.chars.size(), glyph_instance_t::max_glyphs);
+        glUniform2fv(glGetUniformLocation(program, "glyphPos"), slots * 6, table.corners);
+        glUniform4fv(glGetUniformLocation(program, "glyphTex"), slots * 6, &table.tex[0][0]);
+
+        // Base instances need GL 4.2, each run moves the attribute offsets instead
+        glBindVertexArray(instance_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+        for (size_t i = 0; i < draw_count.size(); i++) {
+            glyph_instance_t().set_attrib_pointers(draw_first[i]);
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, draw_count[i]);
+        }
+    }
+
+    void render_dots() {
+        if (dot_count.empty())
+            return;
+
+        size_t dots = 0;
+        for (GLsizei c : dot_count)
+            dots += c;
+        profile::count("vertices", dots);
+
+        dot_program->use();
+        dot_program->set_f("pixelScale", pixel_scale);
+
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glBindVertexArray(dot_vao);
+        glMultiDrawArrays(GL_POINTS, dot_first.data(), dot_count.data(), dot_count.size());
+    }
+
+    void render_density() {
+        if (density_bands.empty())
+            return;
+
+        // Unit 1 so the glyph atlas stays bound
+        glActiveTexture(GL_TEXTURE1);
+        if (density_dirty) {
+            profile::count("bytes uploaded", lod.grid.upload(density_texture));
+            density_dirty = false;
+        }
+        glBindTexture(GL_TEXTURE_2D, density_texture);
+        glActiveTexture(GL_TEXTURE0);
+
+        density_program->use();
+
+        GLint program;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glm::vec2 center_pos = (glm::vec2(XYWH) + glm::vec2(XYWH[2], XYWH[3])) * 0.5f;
+        glUniform1i(glGetUniformLocation(program, "density"), 1);
+        glUniform2fv(glGetUniformLocation(program, "center"), 1, &center_pos[0]);
+        glUniform4fv(glGetUniformLocation(program, "rect"), 1, &lod.grid.rect[0]);
+
+        // Any VAO will do, the quad comes from gl_VertexID
+        glBindVertexArray(vao);
+        for (auto &band : density_bands) {
+            glUniform2fv(glGetUniformLocation(program, "band"), 1, &band[0]);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        profile::count("vertices", density_bands.size() * 4);
+    }
+
+    public:
+    void render() override {
+        // Base render binds the glyph texture, it only draws verticies itself for exports
+        ui_text_t::render();
+
+        if (!atlas_mipmapped)
+            mipmap_atlas();
+
+        if (exporting || meshed_count < 1)
+            return;
+
+        {
+            profile::scope_t scope("cull");
+            visible_runs();
+        }
+        render_quads();
+        render_dots();
+        render_density();
+    }
+
+    // Every shown glyph at its place on the spiral, in spiral_kernel form, for exports
+    struct placement_t {
+        std::vector<float> angles, radii, scales;
+        std::vector<uint32_t> slots;
+        glyph_table_t table;
+        glm::vec2 center;
+        float reach = 0; // furthest any corner gets from its glyph center at scale 1
+    };
+
+    // Same layout and auto-fit as a full rebuild
+    void place(placement_t &p) {
+        size_t count = glyph_count();
+        spiral_layout_t l = layout();
+        float angle = l.base_angle;
+
+        if (l.reverse_dir) {
+            std::lock_guard<std::mutex> lock(fit_lock);
+            auto f = fit.fit(l, count);
+            l = f.layout;
+            angle = f.start;
+        }
+
+        p.angles.resize(count);
+        p.radii.resize(count);
+        p.scales.resize(count);
+        p.slots.resize(count);
+
+        if (source)
+            source->will_read(0, count);
+
+        for (size_t i = 0; i < count; i++) {
+            p.slots[i] = glyph_index(glyph(i), p.table);
+            p.angles[i] = angle;
+            p.radii[i] = l.radii_at(angle);
+            p.scales[i] = sqrt(2.0f) * l.char_scale * l.second_scale_at(angle);
+            angle += l.step_at(angle);
+        }
+
+        p.center = (glm::vec2(XYWH) + glm::vec2(XYWH[2], XYWH[3])) * 0.5f;
+        p.reach = reach(p.table);
+    }
+
+    // Verticies of the placed glyphs in ids, safe to call from any thread
+    static void mesh_placed(const placement_t &p, const std::vector<uint32_t> &ids, std::vector<text_t> &out) {
+        constexpr size_t batch = 4096;
+
+        std::vector<float> angles(batch), radii(batch), scales(batch);
+        std::vector<uint32_t> slots(batch);
+        out.resize(ids.size() * 6);
+
+        for (size_t first = 0; first < ids.size(); first += batch) {
+            size_t n = std::min(batch, ids.size() - first);
+
+            for (size_t i = 0; i < n; i++) {
+                uint32_t id = ids[first + i];
+                angles[i] = p.angles[id];
+                radii[i] = p.radii[id];
+                scales[i] = p.scales[id];
+                slots[i] = p.slots[id];
+            }
+
+            transform({angles.data(), radii.data(), scales.data(), slots.data(), n}, p.table, p.center, &out[first * 6]);
+        }
+    }
+
+    // Draw these verticies instead of the spiral from now on, for exports
+    void render_placed(const std::vector<text_t> &verticies) {
+        exporting = true;
+        meshed_packed = false;
+        upload(verticies.data(), 0, verticies.size());
+        meshed_count = verticies.size() / 6;
+        meshed_instanced = false;
+        set_counts();
+    }
+
+    bool exporting = false;
+};
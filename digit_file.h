@@ -0,0 +1,237 @@
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "digit_source.h"
+
+// Memory mapped digit file, either plain ASCII ("3.1415...") or packed BCD
+//
+// Packed files start with packed_magic and a little endian uint64 character
+// count, followed by two characters per byte, high nibble first. Nibbles
+// 0-9 are digits and 0xA is the decimal point.
+//
+// ASCII files can have anything between the digits (line breaks, say), it
+// gets skipped. A thread walks the mapping once and notes where every
+// block_chars-th character sits, and like the generator the file grows as
+// that index does. Blocks without anything to skip are read straight from
+// the mapping, others step over the skipped bytes from the block start.
+struct digit_file_t : public digit_source_t {
+    static constexpr char packed_magic[8] = {'P','I','B','C','D','4','\n','\0'};
+    static constexpr size_t header_size = sizeof packed_magic + sizeof(uint64_t);
+    static constexpr size_t read_ahead = 1 << 20;
+
+    // Byte offsets are a uint64_t per super_chars characters plus a uint16_t per block_chars from there
+    static constexpr size_t block_chars = 64;
+    static constexpr size_t super_chars = 4096;
+    static constexpr size_t publish_chars = 1 << 16;
+
+    digit_file_t() {}
+
+    ~digit_file_t() {
+        close();
+    }
+
+    // Returns true on failure like the other loaders
+    bool load(const char *path) {
+        close();
+
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return true;
+
+        struct stat st;
+        if (fstat(fd, &st) || st.st_size < 1) {
+            close();
+            return true;
+        }
+
+        length = st.st_size;
+        map = (const uint8_t*)mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            map = nullptr;
+            close();
+            return true;
+        }
+
+        madvise((void*)map, length, MADV_SEQUENTIAL);
+
+        if (length >= header_size && memcmp(map, packed_magic, sizeof packed_magic) == 0) {
+            uint64_t count = 0;
+            for (int i = 0; i < 8; i++)
+                count |= uint64_t(map[sizeof packed_magic + i]) << (i * 8);
+            packed = true;
+            chars = std::min<uint64_t>(count, (length - header_size) * 2);
+            finished = true;
+        } else {
+            // Left uninitialized, pages only get touched as the index reaches them
+            packed = false;
+            supers.reset(new uint64_t[length / super_chars + 1]);
+            blocks.reset(new uint16_t[length / block_chars + 1]);
+            indexer = std::thread(&digit_file_t::index, this);
+        }
+
+        return false;
+    }
+
+    void close() {
+        stop = true;
+        if (indexer.joinable())
+            indexer.join();
+        stop = false;
+        finished = false;
+
+        if (map)
+            munmap((void*)map, length);
+        if (fd >= 0)
+            ::close(fd);
+        map = nullptr;
+        fd = -1;
+        supers.reset();
+        blocks.reset();
+        chars = length = 0;
+        indexed = 0;
+    }
+
+    size_t size() const override {
+        return packed ? chars : indexed.load(std::memory_order_acquire);
+    }
+
+    char at(size_t i) const override {
+        if (!packed)
+            return map[offset(i)];
+        uint8_t byte = map[header_size + i / 2];
+        uint8_t nibble = i & 1 ? byte & 0xF : byte >> 4;
+        return nibble == 0xA ? '.' : '0' + nibble;
+    }
+
+    bool done() const override {
+        return finished.load();
+    }
+
+    void will_read(size_t pos, size_t count) const override {
+        if (!map || pos >= size())
+            return;
+
+        size_t first = packed ? header_size + pos / 2 : offset(pos);
+        size_t last = packed ? header_size + (pos + count + read_ahead) / 2 : first + count + read_ahead;
+        last = std::min(last, length);
+
+        size_t page = sysconf(_SC_PAGESIZE);
+        first -= first % page;
+        madvise((void*)(map + first), last - first, MADV_WILLNEED);
+    }
+
+    size_t read(size_t pos, char *dst, size_t count) const override {
+        size_t have = size();
+        if (pos >= have)
+            return 0;
+        count = std::min(count, have - pos);
+        if (packed)
+            return digit_source_t::read(pos, dst, count);
+
+        // One lookup, then a walk over the bytes
+        for (size_t p = offset(pos), n = 0; n < count; p++)
+            if (keep(map[p]))
+                dst[n++] = map[p];
+        return count;
+    }
+
+    // Write the available characters of src as a packed file
+    static bool write_packed(const char *path, const digit_source_t &src) {
+        FILE *file = fopen(path, "wb");
+        if (!file)
+            return true;
+
+        uint64_t count = src.size();
+        uint8_t header[header_size];
+        memcpy(header, packed_magic, sizeof packed_magic);
+        for (int i = 0; i < 8; i++)
+            header[sizeof packed_magic + i] = (count >> (i * 8)) & 0xFF;
+        bool ok = fwrite(header, 1, header_size, file) == header_size;
+
+        const size_t chunk = 1 << 16;
+        char in[chunk];
+        uint8_t out[chunk / 2];
+        for (size_t pos = 0; ok && pos < count; pos += chunk) {
+            size_t n = src.read(pos, in, chunk);
+            for (size_t i = 0; i < n; i += 2) {
+                auto nib = [](char ch) { return ch == '.' ? 0xA : (ch - '0') & 0xF; };
+                out[i / 2] = nib(in[i]) << 4 | (i + 1 < n ? nib(in[i + 1]) : 0);
+            }
+            ok = fwrite(out, 1, (n + 1) / 2, file) == (n + 1) / 2;
+        }
+
+        ok = fclose(file) == 0 && ok;
+        return !ok;
+    }
+
+    protected:
+    static bool keep(uint8_t ch) {
+        return (ch >= '0' && ch <= '9') || ch == '.';
+    }
+
+    size_t block_start(size_t b) const {
+        return supers[b * block_chars / super_chars] + blocks[b];
+    }
+
+    // Byte of ASCII character i, below size()
+    size_t offset(size_t i) const {
+        size_t b = i / block_chars;
+        size_t p = block_start(b);
+        size_t skip = i % block_chars;
+        if ((b + 1) * block_chars < size() && block_start(b + 1) - p == block_chars)
+            return p + skip;
+        for (;; p++)
+            if (keep(map[p]) && !skip--)
+                return p;
+    }
+
+    void index() {
+        size_t n = 0;
+        for (size_t p = 0; p < length && !stop; p++) {
+            if (!keep(map[p]))
+                continue;
+
+            if (n % block_chars == 0) {
+                if (n % super_chars == 0)
+                    supers[n / super_chars] = p;
+                size_t delta = p - supers[n / super_chars];
+                if (delta > UINT16_MAX) {
+                    fprintf(stderr, "Digit file has too much besides digits around byte %zu, stopping there\n", p);
+                    break;
+                }
+                blocks[n / block_chars] = delta;
+            }
+
+            if (++n % publish_chars == 0)
+                indexed.store(n, std::memory_order_release);
+        }
+
+        indexed.store(n, std::memory_order_release);
+        finished = true;
+    }
+
+    int fd = -1;
+    const uint8_t *map = nullptr;
+    size_t length = 0;
+    size_t chars = 0; // packed files only, ASCII ones have indexed
+    bool packed = false;
+
+    std::unique_ptr<uint64_t[]> supers;
+    std::unique_ptr<uint16_t[]> blocks;
+    std::atomic<size_t> indexed = 0;
+    std::atomic<bool> finished = false;
+    std::atomic<bool> stop = false;
+    std::thread indexer;
+};
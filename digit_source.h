@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// A stream of pi characters ("3.1415...") that can be read while it grows
+//
+// Anything below size() stays valid and may be read from any thread.
+struct digit_source_t {
+    virtual ~digit_source_t() {}
+
+    // Characters ready to read
+    virtual size_t size() const = 0;
+
+    virtual char at(size_t i) const = 0;
+
+    // No more characters will show up
+    virtual bool done() const { return true; }
+
+    // Hint that [pos, pos + count) is about to be read
+    virtual void will_read(size_t pos, size_t count) const {}
+
+    // Copy up to count characters starting at pos, returns the amount copied
+    virtual size_t read(size_t pos, char *dst, size_t count) const {
+        size_t have = size();
+        if (pos >= have)
+            return 0;
+        if (count > have - pos)
+            count = have - pos;
+        for (size_t i = 0; i < count; i++)
+            dst[i] = at(pos + i);
+        return count;
+    }
+};
+
+// src followed by random digits, pad() adds more once src is done
+//
+// Like the spiral always did, it keeps growing after the real digits run
+// out. A padding digit is a hash of its position, so nothing is stored and
+// every thread reads the same one.
+struct padded_source_t : public digit_source_t {
+    padded_source_t(digit_source_t *src):src(src) {}
+
+    ~padded_source_t() {
+        delete src;
+    }
+
+    size_t size() const override {
+        return src->size() + padding.load(std::memory_order_acquire);
+    }
+
+    char at(size_t i) const override {
+        size_t have = src->size();
+        if (i < have)
+            return src->at(i);
+        uint64_t x = (i + 1) * 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 31)) * 0xBF58476D1CE4E5B9ull;
+        return '0' + (x ^ (x >> 27)) % 10;
+    }
+
+    bool done() const override {
+        return src->done();
+    }
+
+    void will_read(size_t pos, size_t count) const override {
+        src->will_read(pos, count);
+    }
+
+    size_t read(size_t pos, char *dst, size_t count) const override {
+        size_t n = src->read(pos, dst, count);
+        if (n < count && src->done())
+            n += digit_source_t::read(pos + n, dst + n, count - n);
+        return n;
+    }
+
+    // Does nothing until src has every digit it's going to have
+    void pad(size_t count) {
+        if (src->done())
+            padding.fetch_add(count, std::memory_order_release);
+    }
+
+    digit_source_t *src;
+    std::atomic<size_t> padding = 0;
+};
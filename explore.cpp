@@ -0,0 +1,261 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "presets.h"
+#include "spiral_layout.h"
+#include "steal_pool.h"
+
+// Searches the slider space for good spiral layouts, no window or GL needed
+//
+// Candidates are sampled over the slider ranges, laid out for --digits
+// characters with the same math and reverse_dir auto-fit as
+// ui_circle_text_t::build() and scored on how much of the window's disc
+// they fill, how small the smallest glyph gets and how far neighbouring
+// rings overlap. The Pareto front goes to a presets file for --presets.
+//
+//   ./explore [--digits n] [--count n] [--seed n] [--threads n] [--keep n]
+//             [--reach r] [--window WxH] [--forward] [--out presets.txt]
+
+namespace explore {
+    size_t digits = 100000;
+    size_t count = 4096;
+    unsigned seed = 314159;
+    unsigned threads = std::thread::hardware_concurrency();
+    size_t keep = 32;
+    float reach = 0.02; // half diagonal of a glyph at scale 1 in vertex coords, ui_circle_text_t::reach() of the atlas
+    int window_width = 800, window_height = 800;
+    bool forward = false;
+    const char *out_path = "presets.txt";
+
+    // Cells per side of the coverage grid over the window
+    const int grid = 256;
+
+    struct range_t {
+        float lo, hi;
+    };
+
+    // The slider ranges from main.cpp, scale and radii scale 2 kept off 0 where nothing shows
+    const range_t scale = {0.2, 2}, chars = {20, 500}, center = {0, 1}, angle = {-0.2, 0.2};
+    const range_t radii_1 = {0, 2}, radii_2 = {0.2, 2};
+
+    struct candidate_t {
+        preset_t preset;
+        bool valid = false;
+    };
+
+    // Per thread buffers, so evaluating allocates once
+    struct scratch_t {
+        std::vector<float> angles;
+        std::vector<uint8_t> cover;
+    };
+
+    int parse_args(int argc, char **argv) {
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], "--digits") && i + 1 < argc && (digits = strtoull(argv[++i], nullptr, 10)) > 1)
+                continue;
+            else if (!strcmp(argv[i], "--count") && i + 1 < argc && (count = strtoull(argv[++i], nullptr, 10)) > 0)
+                continue;
+            else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+                seed = strtoul(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--threads") && i + 1 < argc && (threads = atoi(argv[++i])) > 0)
+                continue;
+            else if (!strcmp(argv[i], "--keep") && i + 1 < argc && (keep = strtoull(argv[++i], nullptr, 10)) > 0)
+                continue;
+            else if (!strcmp(argv[i], "--reach") && i + 1 < argc && (reach = atof(argv[++i])) > 0)
+                continue;
+            else if (!strcmp(argv[i], "--window") && i + 1 < argc &&
+                     sscanf(argv[++i], "%ix%i", &window_width, &window_height) == 2 &&
+                     window_width > 0 && window_height > 0)
+                continue;
+            else if (!strcmp(argv[i], "--forward"))
+                forward = true;
+            else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+                out_path = argv[++i];
+            else {
+                fprintf(stderr, "Usage: %s [--digits n] [--count n] [--seed n] [--threads n] [--keep n]\n"
+                                "          [--reach r] [--window WxH] [--forward] [--out presets.txt]\n", argv[0]);
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    std::vector<candidate_t> sample() {
+        std::mt19937 rng(seed);
+        auto pick = [&](const range_t &r) { return std::uniform_real_distribution<float>(r.lo, r.hi)(rng); };
+
+        std::vector<candidate_t> out(count);
+
+        // The app's own defaults go first so there's always something to compare with
+        out[0].preset = {1.0, D_PI / 0.024f, 0.178, 0, 0.483, 1.8, !forward};
+
+        for (size_t i = 1; i < count; i++)
+            out[i].preset = {pick(scale), pick(chars), pick(center), pick(angle), pick(radii_1), pick(radii_2), !forward};
+
+        return out;
+    }
+
+    // Lay out digits characters of p and fill in its scores, false if they don't all show
+    bool evaluate(preset_t &p, scratch_t &s) {
+        spiral_layout_t l = {D_PI / p.base_chars, p.base_center_dist, p.base_angle, p.char_scale, p.radii_scale_1, p.radii_scale_2, p.reverse_dir};
+        float a = l.base_angle;
+
+        if (l.reverse_dir) {
+            auto f = spiral_fit_t::solve(l, digits);
+            l = f.layout;
+            a = f.start;
+        }
+
+        // Same walk as the mesh, a step that can't move the angle any more never ends
+        s.angles.resize(digits);
+        for (size_t i = 0; i < digits; i++) {
+            s.angles[i] = a;
+            float next = a + l.step_at(a);
+            if (!std::isfinite(next) || next == a)
+                return false;
+            a = next;
+        }
+        float top = *std::max_element(s.angles.begin(), s.angles.end());
+
+        // perspective_matrix maps the spiral to the window at this many pixels per vertex coord unit
+        float px = hypot(window_width, window_height) / 4;
+        float to_ndc_x = px / (window_width * 0.5f), to_ndc_y = px / (window_height * 0.5f);
+
+        s.cover.assign(grid * grid, 0);
+        float min_px = INFINITY, overlap = 0;
+        size_t rings = 0;
+
+        for (float g : s.angles) {
+            float r = l.radii_at(g);
+            // Half the glyph's side, reach is out to its corners
+            float e = l.char_scale * l.second_scale_at(g) * reach;
+            if (!std::isfinite(r) || !std::isfinite(e))
+                return false;
+
+            float x = r * sin(g) * to_ndc_x, y = r * cos(g) * to_ndc_y;
+            if (x * x + y * y > 1)
+                return false;
+
+            min_px = std::min(min_px, 2 * e * px);
+
+            int x0 = std::max(0, (int)((x - e * to_ndc_x + 1) * 0.5f * grid));
+            int x1 = std::min(grid - 1, (int)((x + e * to_ndc_x + 1) * 0.5f * grid));
+            int y0 = std::max(0, (int)((y - e * to_ndc_y + 1) * 0.5f * grid));
+            int y1 = std::min(grid - 1, (int)((y + e * to_ndc_y + 1) * 0.5f * grid));
+            for (int cy = y0; cy <= y1; cy++)
+                memset(&s.cover[cy * grid + x0], 1, std::max(0, x1 - x0 + 1));
+
+            // The glyph a turn further out, if the spiral got that far
+            float out = g + D_PI;
+            if (out <= top) {
+                float gap = std::abs(l.radii_at(out) - r);
+                float need = e + l.char_scale * l.second_scale_at(out) * reach;
+                overlap += std::max(0.0f, need - gap) / need;
+                rings++;
+            }
+        }
+
+        size_t inside = 0, covered = 0;
+        for (int cy = 0; cy < grid; cy++) {
+            for (int cx = 0; cx < grid; cx++) {
+                float x = (cx + 0.5f) / grid * 2 - 1, y = (cy + 0.5f) / grid * 2 - 1;
+                if (x * x + y * y > 1)
+                    continue;
+                inside++;
+                covered += s.cover[cy * grid + cx];
+            }
+        }
+
+        p.fill = (float)covered / inside;
+        p.min_px = min_px;
+        p.overlap = rings ? overlap / rings : 0;
+        return true;
+    }
+
+    bool dominates(const preset_t &a, const preset_t &b) {
+        return a.fill >= b.fill && a.min_px >= b.min_px && a.overlap <= b.overlap &&
+               (a.fill > b.fill || a.min_px > b.min_px || a.overlap < b.overlap);
+    }
+
+    // Candidates nothing else beats on every score, most filled first, thinned out evenly to keep
+    std::vector<preset_t> front(const std::vector<candidate_t> &candidates) {
+        std::vector<preset_t> best;
+        for (auto &c : candidates) {
+            if (!c.valid)
+                continue;
+            bool beaten = false;
+            for (auto &o : candidates) {
+                if (o.valid && dominates(o.preset, c.preset)) {
+                    beaten = true;
+                    break;
+                }
+            }
+            if (!beaten)
+                best.push_back(c.preset);
+        }
+
+        std::sort(best.begin(), best.end(), [](const preset_t &a, const preset_t &b) { return a.fill > b.fill; });
+
+        if (best.size() > keep) {
+            std::vector<preset_t> thin;
+            for (size_t i = 0; i < keep; i++)
+                thin.push_back(best[keep > 1 ? i * (best.size() - 1) / (keep - 1) : 0]);
+            best = thin;
+        }
+
+        return best;
+    }
+
+    int run() {
+        std::vector<candidate_t> candidates = sample();
+        steal_pool_t pool(threads);
+        std::vector<scratch_t> scratch(pool.threads);
+
+        auto start = std::chrono::steady_clock::now();
+        pool.run(candidates.size(), [&](size_t i, unsigned w) {
+            candidates[i].valid = evaluate(candidates[i].preset, scratch[w]);
+        });
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t valid = std::count_if(candidates.begin(), candidates.end(), [](const candidate_t &c) { return c.valid; });
+        std::vector<preset_t> best = front(candidates);
+
+        fprintf(stderr, "%zu candidates at %zu digits in %.2fs on %u threads (%zu steals), %zu show every digit, %zu presets\n",
+                candidates.size(), digits, time, pool.threads, pool.steals.load(), valid, best.size());
+
+        if (best.empty()) {
+            fprintf(stderr, "Error: no candidate fits, try fewer --digits\n");
+            return 1;
+        }
+
+        char header[256];
+        snprintf(header, sizeof header, "# explore --digits %zu --count %zu --seed %u --reach %g --window %ix%i\n",
+                 digits, count, seed, reach, window_width, window_height);
+        if (preset_t::write(out_path, header, best)) {
+            fprintf(stderr, "Error: failed to write %s\n", out_path);
+            return 1;
+        }
+
+        for (auto &p : best)
+            printf("fill %.3f  min %6.2f px  overlap %.3f  scale %.3f chars %.1f center %.3f angle %.3f radii %.3f %.3f\n",
+                   p.fill, p.min_px, p.overlap, p.char_scale, p.base_chars, p.base_center_dist, p.base_angle, p.radii_scale_1, p.radii_scale_2);
+
+        return 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (explore::parse_args(argc, argv))
+        return 1;
+
+    return explore::run();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common.h"
+
+// One glyph of the instanced circle text path
+//
+// A unit of 6 verticies is drawn per instance and shaders/text_instanced_vertex.glsl
+// rotates the glyph table entry into place, 16 bytes instead of 6 text_t verticies.
+struct glyph_instance_t {
+    float angle;
+    float radii;
+    float scale;
+    uint32_t glyph;
+
+    static constexpr int max_glyphs = 16;
+
+    // Attributes start at instance first, which stands in for a base instance on GL 3.3
+    void set_attrib_pointers(size_t first = 0) const {
+        size_t base = first * sizeof(glyph_instance_t);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glyph_instance_t), (void*)(base + offsetof(glyph_instance_t, angle)));
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(glyph_instance_t), (void*)(base + offsetof(glyph_instance_t, glyph)));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(0, 1);
+        glVertexAttribDivisor(1, 1);
+    }
+};
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <string.h>
+#include <strings.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#if __has_include("stb_image_write.h")
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+#define HEADLESS_PNG 1
+#else
+#define HEADLESS_PNG 0
+#endif
+
+// Without a display GLFW 3.4 can still make an OSMesa context (Mesa
+// software GL) on its null platform, call before glfwInit
+inline void headless_init_hints() {
+#ifdef GLFW_PLATFORM_NULL
+    if (!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY"))
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+}
+
+// Hidden window, only there for its context
+inline void headless_window_hints() {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+    if (glfwGetPlatform() == GLFW_PLATFORM_NULL)
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+}
+
+// Writes finished frames on its own thread
+//
+// "-" streams raw RGBA frames to stdout (top row first), anything else is a
+// printf pattern for numbered images like "frames/%05d.png". A .png pattern
+// writes png when stb_image_write is around and .ppm files in its place
+// otherwise, any other extension is ppm. The queue is bounded so a slow
+// encoder holds the renderer back instead of eating memory.
+struct frame_writer_t {
+    static constexpr size_t max_queued = 4;
+
+    frame_writer_t(const char *path, int width, int height)
+    :path(path), pattern(image_pattern(path)), width(width), height(height), worker(&frame_writer_t::run, this) {}
+
+    ~frame_writer_t() {
+        close();
+    }
+
+    // Write out everything queued and stop the thread
+    void close() {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        changed.notify_all();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    // Hand over a bottom up RGBA frame as read from GL
+    void push(std::vector<uint8_t> &&frame) {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [this]{ return queue.size() < max_queued; });
+        queue.push_back(std::move(frame));
+        changed.notify_all();
+    }
+
+    // Recycle a written frame so push() callers don't allocate every frame
+    std::vector<uint8_t> take_spare() {
+        std::lock_guard lock(mutex);
+        if (spare.empty())
+            return std::vector<uint8_t>((size_t)width * height * 4);
+        std::vector<uint8_t> frame = std::move(spare.back());
+        spare.pop_back();
+        return frame;
+    }
+
+    bool failed() const { return error; }
+
+    protected:
+    static bool is_png(const std::string &p) {
+        return p.size() >= 4 && !strcasecmp(p.c_str() + p.size() - 4, ".png");
+    }
+
+    // Swaps .png for .ppm when there's nothing to encode png with
+    static std::string image_pattern(const char *path) {
+        std::string p = path;
+        if (!HEADLESS_PNG && strcmp(path, "-") && is_png(p)) {
+            p.replace(p.size() - 4, 4, ".ppm");
+            fprintf(stderr, "No stb_image_write.h, writing %s instead\n", p.c_str());
+        }
+        return p;
+    }
+
+    void run() {
+        while (true) {
+            std::vector<uint8_t> frame;
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [this]{ return stop || !queue.empty(); });
+                if (queue.empty())
+                    break;
+                frame = std::move(queue.front());
+                queue.pop_front();
+                changed.notify_all();
+            }
+
+            if (!error && write(frame))
+                error = true;
+            index++;
+
+            std::lock_guard lock(mutex);
+            spare.push_back(std::move(frame));
+        }
+
+        if (!strcmp(path, "-"))
+            fflush(stdout);
+    }
+
+    int write(const std::vector<uint8_t> &frame) {
+        size_t row = (size_t)width * 4;
+
+        if (!strcmp(path, "-")) {
+            for (int y = height - 1; y >= 0; y--)
+                if (fwrite(&frame[y * row], 1, row, stdout) != row)
+                    return 1;
+            return glsuccess;
+        }
+
+        char name[4096];
+        snprintf(name, sizeof(name), pattern.c_str(), index);
+
+#if HEADLESS_PNG
+        if (is_png(pattern)) {
+            stbi_flip_vertically_on_write(1);
+            return stbi_write_png(name, width, height, 4, frame.data(), row) ? glsuccess : 1;
+        }
+#endif
+        FILE *f = fopen(name, "wb");
+        if (!f)
+            return 1;
+        fprintf(f, "P6 %i %i 255\n", width, height);
+        std::vector<uint8_t> rgb((size_t)width * 3);
+        for (int y = height - 1; y >= 0; y--) {
+            for (int x = 0; x < width; x++)
+                memcpy(&rgb[x * 3], &frame[y * row + x * 4], 3);
+            fwrite(rgb.data(), 1, rgb.size(), f);
+        }
+        return fclose(f) ? 1 : glsuccess;
+    }
+
+    const char *path;
+    std::string pattern; // path with the extension that actually gets written
+    int width, height;
+    int index = 0;
+    std::atomic<bool> error = false;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> queue, spare;
+    bool stop = false;
+    std::thread worker;
+};
+
+// Offscreen render target with asynchronous readback
+//
+// Frames render into an FBO of any size. Each capture() starts a
+// glReadPixels into one of two pixel buffers and maps the other one, which
+// holds the previous frame and has finished copying by now, so the GPU
+// never stalls waiting on the CPU. Mapped frames go to the sink, bottom row
+// first, in the order they were captured.
+struct headless_t {
+    using sink_t = std::function<int(const uint8_t *pixels)>;
+
+    int width, height;
+
+    headless_t(int width, int height)
+    :width(width), height(height) {}
+
+    ~headless_t() {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &color);
+        glDeleteBuffers(2, pbo);
+    }
+
+    // Stream every frame to a frame_writer_t
+    int load(const char *out_path) {
+        writer = std::make_unique<frame_writer_t>(out_path, width, height);
+        return load([this](const uint8_t *pixels) {
+            if (writer->failed())
+                return 1;
+            std::vector<uint8_t> frame = writer->take_spare();
+            memcpy(frame.data(), pixels, frame.size());
+            writer->push(std::move(frame));
+            return (int)glsuccess;
+        });
+    }
+
+    int load(sink_t sink) {
+        this->sink = sink;
+
+        glGenRenderbuffers(1, &color);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            return 1;
+
+        size_t size = (size_t)width * height * 4;
+        glGenBuffers(2, pbo);
+        for (int i = 0; i < 2; i++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        return glsuccess;
+    }
+
+    void bind() {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+    }
+
+    // Queue the current frame and write out the previous one
+    int capture() {
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[frames % 2]);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+        int ret = glsuccess;
+        if (frames > 0)
+            ret = drain(pbo[(frames - 1) % 2]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        frames++;
+        return ret;
+    }
+
+    // Write the last frame still sitting in a pixel buffer and wait for the writer
+    int finish() {
+        int ret = glsuccess;
+        if (frames > 0) {
+            ret = drain(pbo[(frames - 1) % 2]);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        if (writer) {
+            writer->close();
+            if (writer->failed())
+                ret = 1;
+        }
+        return ret;
+    }
+
+    size_t frame_count() const { return frames; }
+
+    protected:
+    int drain(GLuint buffer) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        void *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (!pixels)
+            return 1;
+
+        int ret = sink((const uint8_t*)pixels);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+        return ret;
+    }
+
+    GLuint fbo = 0, color = 0;
+    GLuint pbo[2] = {0, 0};
+    size_t frames = 0;
+    sink_t sink;
+    std::unique_ptr<frame_writer_t> writer;
+};
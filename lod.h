@@ -0,0 +1,166 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "common.h"
+
+// Cheaper stand ins for glyphs too small to read
+//
+// Chunks whose glyphs come out at least quad_px pixels tall are drawn as
+// textured quads, down to dot_px as one point each (shaders/lod_dot_*.glsl)
+// and below that as a density texture of the ink they would have left
+// (shaders/lod_density_*.glsl), so what gets drawn stays about the same no
+// matter how many digits are on screen.
+namespace lod {
+    enum level_t { quads, dots, density };
+
+    // Part of a glyph box that is actually ink, for the dots and density
+    constexpr float ink = 0.25;
+
+    // One point per glyph for the dots level
+    struct dot_t {
+        glm::vec2 pos; // glyph center in vertex coords
+        float size;    // glyph box size
+        float value;   // digit value, -1 for anything else
+
+        void set_attrib_pointers() const {
+            glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(dot_t), (void*)0);
+            glEnableVertexAttribArray(0);
+        }
+    };
+
+    // Bounds of a run of chunk_glyphs characters
+    struct chunk_t {
+        glm::vec4 box = glm::vec4(1e30f, 1e30f, -1e30f, -1e30f); // min x, min y, max x, max y in vertex coords
+        float size = 0; // largest glyph box
+        float radii_min = 1e30f, radii_max = 0; // glyph center distance from the spiral center
+
+        void add(const glm::vec4 &b, float r) {
+            box = glm::vec4(std::min(box[0], b[0]), std::min(box[1], b[1]), std::max(box[2], b[2]), std::max(box[3], b[3]));
+            size = std::max(size, b[2] - b[0]);
+            radii_min = std::min(radii_min, r);
+            radii_max = std::max(radii_max, r);
+        }
+    };
+
+    inline level_t pick(float size_px, float quad_px, float dot_px) {
+        return size_px >= quad_px ? quads : size_px >= dot_px ? dots : density;
+    }
+
+    // Ink coverage per texel over a square around the spiral, with its mip levels
+    //
+    // Only the rows dots landed in since the last upload are sent, along with
+    // the rows of every mip level they feed, averaged here instead of by
+    // glGenerateMipmap so an append doesn't redo the whole chain.
+    struct density_grid_t {
+        static constexpr int size = 512;
+
+        glm::vec4 rect = glm::vec4(0.0f); // min x, min y, max x, max y in vertex coords
+        std::vector<float> cover;
+        std::vector<std::vector<float>> mips; // size / 2 on down to 1x1
+        int dirty_min = size, dirty_max = 0; // rows of cover not uploaded yet
+
+        void reset(const glm::vec4 &r) {
+            rect = r;
+            cover.assign(size * size, 0);
+            mips.clear();
+            for (int s = size / 2; s >= 1; s /= 2)
+                mips.emplace_back(s * s, 0.0f);
+            dirty_min = 0;
+            dirty_max = size;
+        }
+
+        // Doubles rect around its center, the old coverage shrinks into the middle
+        void grow() {
+            float cx = (rect[0] + rect[2]) * 0.5f, cy = (rect[1] + rect[3]) * 0.5f;
+            float hx = rect[2] - rect[0], hy = rect[3] - rect[1];
+            rect = glm::vec4(cx - hx, cy - hy, cx + hx, cy + hy);
+
+            std::vector<float> old(size * size, 0);
+            std::swap(old, cover);
+            // A texel now has 4 times the area, so it gets the average of the 4 it replaces
+            for (int y = 0; y < size; y++)
+                for (int x = 0; x < size; x++)
+                    cover[(size / 4 + y / 2) * size + size / 4 + x / 2] += old[y * size + x] * 0.25f;
+            dirty_min = 0;
+            dirty_max = size;
+        }
+
+        // Dots past rect grow it until they fit
+        void add(const dot_t &d) {
+            if (!std::isfinite(d.pos[0]) || !std::isfinite(d.pos[1]))
+                return;
+
+            float fx, fy, w, h;
+            for (;;) {
+                w = rect[2] - rect[0], h = rect[3] - rect[1];
+                fx = (d.pos[0] - rect[0]) / w * size;
+                fy = (d.pos[1] - rect[1]) / h * size;
+                if (fx >= 0 && fy >= 0 && fx < size && fy < size)
+                    break;
+                grow();
+            }
+
+            int x = fx, y = fy;
+            cover[y * size + x] += d.size * d.size * ink / (w * h / (size * size));
+            dirty_min = std::min(dirty_min, y);
+            dirty_max = std::max(dirty_max, y + 1);
+        }
+
+        // Sends the dirty rows of every level, returns the bytes sent
+        size_t upload(GLuint &texture) {
+            bool fresh = !texture;
+            if (fresh) {
+                glGenTextures(1, &texture);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                dirty_min = 0;
+                dirty_max = size;
+            }
+            glBindTexture(GL_TEXTURE_2D, texture);
+            if (dirty_min >= dirty_max)
+                return 0;
+
+            size_t bytes = 0;
+            int lo = dirty_min, hi = dirty_max;
+            const float *prev = nullptr;
+            for (int level = 0, s = size; s >= 1; level++, s /= 2) {
+                float *data = level ? mips[level - 1].data() : cover.data();
+                // Each texel averages the 2x2 under it one level up
+                for (int y = lo; level && y < hi; y++)
+                    for (int x = 0; x < s; x++) {
+                        const float *p = prev + (y * 2) * s * 2 + x * 2;
+                        data[y * s + x] = (p[0] + p[1] + p[s * 2] + p[s * 2 + 1]) * 0.25f;
+                    }
+
+                if (fresh)
+                    glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, s, s, 0, GL_RED, GL_FLOAT, data);
+                else
+                    glTexSubImage2D(GL_TEXTURE_2D, level, 0, lo, s, hi - lo, GL_RED, GL_FLOAT, data + lo * s);
+                bytes += (fresh ? s : hi - lo) * s * sizeof(float);
+
+                prev = data;
+                lo /= 2;
+                hi = (hi + 1) / 2;
+            }
+
+            dirty_min = size;
+            dirty_max = 0;
+            return bytes;
+        }
+    };
+
+    // Everything the cheaper levels need, built next to the mesh
+    struct index_t {
+        std::vector<chunk_t> chunks;
+        std::vector<dot_t> dots;
+        density_grid_t grid;
+    };
+}
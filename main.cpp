@@ -8,12 +8,18 @@
 #include "ui_slider.h"
 #include "shader_program.h"
 #include "shader.h"
+#include "assets.h"
 #include "bigpi.h"
-
-constexpr float H_PI = 0.5f * M_PI;
-constexpr float D_PI = 2.0f * M_PI;
-const char *pi300 = "3.141592653589793238462643383279502884197169399375105820974944592307816406286208998628034825342117067982148086513282306647093844609550582231725359408128481117450284102701938521105559644622948954930381964428810975665933446128475648233786783165271201909145648566923460348610454326648213393607260249141273";
-const char *pi1000 = "3.1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679821480865132823066470938446095505822317253594081284811174502841027019385211055596446229489549303819644288109756659334461284756482337867831652712019091456485669234603486104543266482133936072602491412737245870066063155881748815209209628292540917153643678925903600113305305488204665213841469519415116094330572703657595919530921861173819326117931051185480744623799627495673518857527248912279381830119491298336733624406566430860213949463952247371907021798609437027705392171762931767523846748184676694051320005681271452635608277857713427577896091736371787214684409012249534301465495853710507922796892589235420199561121290219608640344181598136297747713099605187072113499999983729780499510597317328160963185950244594553469083026425223082533446850352619311881710100031378387528865875332083814206171776691473035982534904287554687311595628638823537875937519577818577805321712268066130019278766111959092164201989";
+#include "camera.h"
+#include "circle_text.h"
+#include "digit_file.h"
+#include "headless.h"
+#include "poster.h"
+#include "presets.h"
+#include "profile.h"
+#include "program_cache.h"
+#include "schedule.h"
+#include "spiral_layout.h"
 
 struct ui_image_t : public ui_element_t {
     ui_image_t(GLFWwindow *window, glm::vec4 xywh)
@@ -33,189 +39,41 @@ struct ui_pi_slider_t : public ui_slider_t {
     }
 };
 
-struct ui_circle_text_t : public ui_text_t {
-    ui_circle_text_t(GLFWwindow *window, shaderProgram_t *program, texture_t *texture, glm::vec4 xywh)
-    :ui_text_t(window, program, texture, xywh) {
-        //base_chars = 150.0;
-        base_chars = D_PI / 0.024;
-        base_dist = D_PI / base_chars;
-        base_center_dist = 0.178;
-        char_scale = 1.0;
-        reverse_dir = true;
-        radii_scale_1 = 0.483;
-        radii_scale_2 = 1.8;
-        modified = true;
-    }
+// A program linked through program_cache_t once it has paths
+struct cached_program_t : public shaderProgram_t {
+    cached_program_t(shaderProgram_t &&prg):shaderProgram_t(prg){}
 
-    void calc() {
-        base_dist = D_PI / base_chars;
-        //base_angle = atan(base_dist / base_center_dist);
-        modified = true;
-    }
+    // Linked through cache from these paths once set, from the base class's shaders otherwise
+    program_cache_t *cache = nullptr;
+    const char *vertex_path = nullptr;
+    const char *fragment_path = nullptr;
 
-    void add_char(const char ch) {
-        string_buffer += ch;
-        string_change();
+    bool load(program_cache_t &c, const char *vertex, const char *fragment) {
+        cache = &c;
+        vertex_path = vertex;
+        fragment_path = fragment;
+        return load();
     }
 
-    float base_chars;
-    float base_dist;
-    float base_center_dist;
-    float base_angle;
-    float char_scale;
-    bool reverse_dir;
-    float radii_scale_1;
-    float radii_scale_2;
-
-    protected:
-    bool mesh() override {
-        currentX = currentY = vertexCount = 0;
-
-        last_used = get_parameters();
-
-        if (string_buffer.size() < 1) {
-            modified = false;
-            return glsuccess;
-        }
-
-        if (!modified)
-            return glsuccess;
-
-        int count = string_buffer.size();
-        text_t *buffer = new text_t[count * 6];
-
-        
-        float angle = base_angle;
-        
-        float max_radii = 0;
-        int iter=0;
-
-        if (reverse_dir) {
-            while (true) {
-                for (int i = 1; i < count; i++) {
-                    float radii = ((angle / D_PI) * base_dist + base_center_dist) * radii_scale_2;
-                    if (radii > max_radii)
-                        max_radii = radii;
-                    float char_angle = atan(base_dist / radii);
-                    float second_scale = abs(pow(radii, radii_scale_1) - radii + 1);
-                    angle += char_angle * second_scale;
-                }
-
-                //printf("%i: angle: %f, max_radii: %f, radii_scale_1: %f, radii_scale_2: %f, char_scale: %f, base_dist: %f, base_center: %f\n",
-                //    iter++, angle, max_radii, radii_scale_1, radii_scale_2, char_scale, base_dist, base_center_dist);
-
-                    //break;
-
-                float bdlim = 0.016;
-                float r2lim = 1.78;
-
-                if (max_radii < 1.4 || (base_dist < bdlim && radii_scale_2 <= r2lim))
-                    break;
-
-                float arb = 500.0;
-                
-                char_scale -= (0.1/arb);
-                if (base_dist > bdlim)
-                    base_dist -= (0.015/arb);
-                //radii_scale_1 -= (0.722/arb);
-                radii_scale_1 -= (0.4/arb);
-                //radii_scale_2 -= (0.810/arb);
-                if (radii_scale_2 > r2lim)
-                    radii_scale_2 -= (0.20/arb);
-                angle = 0;
-                max_radii = 0;
-            } 
-        }
-
-
-
-        //angle += base_angle;
-
-        auto b_it = string_buffer.begin();
-        auto e_it = string_buffer.end();
-
-        if (reverse_dir)
-            std::swap(b_it, e_it);
-
-        auto it = b_it;
-
-        while (true) {
-            if (reverse_dir) {
-                if (it == e_it)
-                    break;
-                it--;
-            }
-            
-            auto ch = *it;
-
-            if (!reverse_dir && it++ == e_it)
-                break;
-                
-            // Generate character verticies and texture coordinates
-            glm::vec4 scr, tex;
-
-            get_parameters()->calculate(ch, 0, 0, XYWH, scr, tex);
-            
-            text_t tmp[6];
-            unsigned int cnt = 0;
-            add_rect(&tmp[0], cnt, scr, tex);
-
-
-            // Rotate around center
-            float center_dist = 0.0f;
-            float radii = ((angle / D_PI) * base_dist + base_center_dist) * radii_scale_2;
-            float second_scale = abs(pow(radii, radii_scale_1) - radii + 1);
-            float char_angle = atan(base_dist / radii);
-
-            center_dist += radii;
-
-            glm::vec2 center_pos = (glm::vec2(XYWH) + glm::vec2(XYWH[2], XYWH[3])) * 0.5f;
-
-            glm::mat4 m1 = glm::rotate(glm::mat4(1.0), -angle, glm::vec3(0,0,1.0));
-            glm::mat4 m2 = glm::rotate(glm::mat4(1.0), -angle + H_PI, glm::vec3(0,0,1.0));
-            
-            glm::vec2 ch_pos = glm::vec2(scr) + (glm::vec2(scr[2], scr[3]) * 0.5f);
-            glm::vec2 offset = center_pos - ch_pos;
-
-            for (int i = 0; i < sizeof tmp / sizeof tmp[0]; i++) {
-                glm::vec2 r = tmp[i].coords();
-                
-                r -= ch_pos;
-
-                r = r * glm::mat2(m1);
-                r *= sqrt(2.0f) * char_scale * second_scale;
-                r += glm::vec2(center_dist, 0) * glm::mat2(m2);
-                
-                r += center_pos;
-                //if center_pos changes use r += offset; r += ch_pos; ?
-                
-                tmp[i].coords() = r;
-            }
-
-            memcpy(&buffer[vertexCount], &tmp[0], cnt * sizeof tmp[0]);
-            
-            vertexCount += cnt;
-            angle += char_angle * (reverse_dir ? -1 : 1) * second_scale;
-            currentX++;
-        }
-
-        modified = false;
-
-        glBindVertexArray(vao);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof * buffer, buffer, GL_STATIC_DRAW);
-
-        buffer->set_attrib_pointers();
+    // Reloads through any pointer end up here too
+    bool load() override {
+        if (!cache)
+            return shaderProgram_t::load();
 
-        delete [] buffer;
+        GLuint program = cache->link(vertex_path, fragment_path);
+        if (!program)
+            return true;
 
+        // Into the base class's handle, so use(), set_f() and set_m4() see it whoever calls them
+        if (id)
+            glDeleteProgram(id);
+        id = program;
         return glsuccess;
     }
 };
 
-struct shader_text_program_t : public shaderProgram_t {
-    shader_text_program_t(shaderProgram_t &&prg):shaderProgram_t(prg){}
+struct shader_text_program_t : public cached_program_t {
+    shader_text_program_t(shaderProgram_t &&prg):cached_program_t(std::move(prg)){}
 
     float mixFactor = 0.0;
 
@@ -237,47 +95,117 @@ namespace program {
     shader_t *text_vertex;
     shader_t *text_fragment;
     shader_text_program_t *text_program;
+    shader_t *instanced_vertex;
+    shader_text_program_t *instanced_program;
+    shader_t *packed_vertex;
+    shader_text_program_t *packed_program;
+    shader_t *dot_vertex;
+    shader_t *dot_fragment;
+    cached_program_t *dot_program;
+    shader_t *density_vertex;
+    shader_t *density_fragment;
+    cached_program_t *density_program;
+    bool instanced = false;
+    bool packed = false;
     ui_circle_text_t *circle_text;
     ui_image_t *pi_image;
     texture_t *text_texture;
     texture_t *pi_texture;
+    asset_loader_t assets;
+    program_cache_t program_cache;
+    bool startup_only = false;
+    bool first_frame = true;
+    auto start_time = std::chrono::steady_clock::now();
+    padded_source_t *digits;
+    const char *digit_path = nullptr;
+    const char *pack_path = nullptr;
+    headless_t *headless = nullptr;
+    int headless_width = 0, headless_height = 0;
+    const char *headless_out = "-";
+    ingest_schedule_t schedule;
+    size_t skip_to = 0;
+    size_t per_frame = 0;
+    double headless_fps = 60;
+    size_t max_frames = 0;
+    const char *poster_path = nullptr;
+    int poster_width = 0, poster_height = 0;
+    int poster_tile = 1024;
+    size_t poster_digits = 0;
+    const char *profile_path = nullptr;
+    const char *presets_path = nullptr;
+    std::vector<preset_t> presets;
+    size_t preset = 0;
+    bool preset_key = false;
+    bool show_hud = false;
+    bool hud_key = false;
+    double hud_time = -1;
+    std::vector<ui_text_t*> hud_lines;
     glm::mat4 perspective_matrix(1.0f);
+    glm::vec2 screen_size(800, 800);
+    camera_t camera;
+    bool dragging = false;
+    glm::vec2 cursor_ndc(0.0f);
     std::vector<ui_slider_t*> sliders;
     glm::vec4 sliderPos(0.45, -0.95, 0.5, 0.1);
     glm::vec4 sliderSize(0.0,0.2,0,0);
     ui_element_t *ui_base;
 
+    void apply_preset(const preset_t &p) {
+        circle_text->char_scale = p.char_scale;
+        circle_text->base_chars = p.base_chars;
+        circle_text->base_center_dist = p.base_center_dist;
+        circle_text->base_angle = p.base_angle;
+        circle_text->radii_scale_1 = p.radii_scale_1;
+        circle_text->radii_scale_2 = p.radii_scale_2;
+        circle_text->reverse_dir = p.reverse_dir;
+        circle_text->calc();
+    }
+
+    // Play dt more seconds of the schedule, returns false once every digit is showing
+    bool advance(double dt, bool wait) {
+        size_t p = circle_text->glyph_count();
+        size_t target = per_frame ? p + per_frame : schedule.step(dt);
+
+        // Frame exports can't skip a beat while the generator catches up
+        while (wait && target > digits->size() && !digits->done())
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        // Everything that arrived this frame goes in as one append
+        target = std::min(target, digits->size());
+        if (target > p)
+            circle_text->show(target);
+
+        return target < digits->size() || !digits->done();
+    }
+
     void handle_keyboard(GLFWwindow *window, double delta_time) {
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             hint_exit();
 
-        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
-            static int p = 4;
-            static int digits = 1;
-            const char *pp = pi100000;
-            if (p < 99999-digits) {
-                char str[digits];
-                memcpy(&str[0], &pi100000[p], digits);
-                circle_text->add_string(std::string(&str[0], digits));
-                p += digits;
-
-                if (p > 100)
-                    digits = 2;
-                if (p > 500)
-                    digits = 3;
-                if (p > 3000)
-                    digits = 4;
-                //if (p > 2000)
-                //    digits = 5;
-                //if (p > 3000)
-                //    digits = 6;
-                if (p > 8000)
-                    digits = 10;
-                if (p > 16000)
-                    digits = 30;
-            } else
-                circle_text->add_char('0' + (rand() % 10));
+        // Once every digit is showing it keeps going with random ones, one a frame
+        if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !advance(delta_time, false)) {
+            digits->pad(1);
+            circle_text->show(digits->size());
+        }
+
+        if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
+            camera = camera_t();
+
+        // H toggles the stats overlay, profiling only runs while something reads it
+        bool h = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+        if (h && !hud_key) {
+            show_hud = !show_hud;
+            profile::enabled.store(show_hud || profile_path, std::memory_order_relaxed);
+        }
+        hud_key = h;
+
+        // P steps through the presets from --presets
+        bool pk = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+        if (pk && !preset_key && !presets.empty()) {
+            preset = (preset + 1) % presets.size();
+            apply_preset(presets[preset]);
         }
+        preset_key = pk;
     }
 
     void handle_buffersize(GLFWwindow *window, int width, int height) {
@@ -286,6 +214,7 @@ namespace program {
         //glfwGetWindowSize(window, &width, &height);
 
         glm::vec2 screen = glm::vec2(width, height);
+        screen_size = screen;
         glm::vec2 scale = glm::normalize(screen);
         perspective_matrix = glm::scale(glm::mat4(1.0f), glm::vec3(scale * 2.0f, 1.0f));
         perspective_matrix = glm::inverse(perspective_matrix);
@@ -294,16 +223,127 @@ namespace program {
 
     void handle_cursorpos(GLFWwindow *window, double x, double y) {
         ui_base->onCursor(x, y);
+
+        int width, height;
+        glfwGetWindowSize(window, &width, &height);
+        glm::vec2 ndc(x / width * 2.0 - 1.0, 1.0 - y / height * 2.0);
+
+        if (dragging)
+            camera.drag(perspective_matrix, cursor_ndc, ndc);
+        cursor_ndc = ndc;
     }
 
     void handle_mousebutton(GLFWwindow *window, int button, int action, int mods) {
         ui_base->onMouse(button, action, mods);
+
+        // Left clicks belong to the sliders
+        if (button == GLFW_MOUSE_BUTTON_RIGHT)
+            dragging = action == GLFW_PRESS;
+    }
+
+    void handle_scroll(GLFWwindow *window, double x, double y) {
+        camera.zoom_at(perspective_matrix, cursor_ndc, pow(1.2, y));
+    }
+
+    int parse_args(int argc, char **argv) {
+        for (int i = 1; i < argc; i++) {
+            if (!strcmp(argv[i], "--digits") && i + 1 < argc)
+                digit_path = argv[++i];
+            else if (!strcmp(argv[i], "--pack") && i + 1 < argc)
+                pack_path = argv[++i];
+            else if (!strcmp(argv[i], "--instanced"))
+                instanced = true;
+            else if (!strcmp(argv[i], "--packed"))
+                packed = true;
+            else if (!strcmp(argv[i], "--headless") && i + 1 < argc &&
+                     sscanf(argv[++i], "%ix%i", &headless_width, &headless_height) == 2 &&
+                     headless_width > 0 && headless_height > 0)
+                continue;
+            else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+                headless_out = argv[++i];
+            else if (!strcmp(argv[i], "--per-frame") && i + 1 < argc)
+                per_frame = strtoull(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--fps") && i + 1 < argc && (headless_fps = atof(argv[++i])) > 0)
+                continue;
+            else if (!strcmp(argv[i], "--rate") && i + 1 < argc && !schedule.parse(argv[++i]))
+                continue;
+            else if (!strcmp(argv[i], "--skip-to") && i + 1 < argc)
+                skip_to = strtoull(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+                max_frames = strtoull(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--poster") && i + 2 < argc &&
+                     sscanf(argv[++i], "%ix%i", &poster_width, &poster_height) == 2 &&
+                     poster_width > 0 && poster_height > 0)
+                poster_path = argv[++i];
+            else if (!strcmp(argv[i], "--tile") && i + 1 < argc && (poster_tile = atoi(argv[++i])) > 0)
+                continue;
+            else if (!strcmp(argv[i], "--poster-digits") && i + 1 < argc)
+                poster_digits = strtoull(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--hud"))
+                show_hud = true;
+            else if (!strcmp(argv[i], "--profile") && i + 1 < argc)
+                profile_path = argv[++i];
+            else if (!strcmp(argv[i], "--presets") && i + 1 < argc)
+                presets_path = argv[++i];
+            else if (!strcmp(argv[i], "--preset") && i + 1 < argc)
+                preset = strtoull(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--shader-cache") && i + 1 < argc)
+                program_cache.dir = argv[++i];
+            else if (!strcmp(argv[i], "--no-shader-cache"))
+                program_cache.enabled = false;
+            else if (!strcmp(argv[i], "--startup"))
+                startup_only = true;
+            else {
+                fprintf(stderr, "Usage: %s [--digits file] [--pack out.bcd] [--instanced|--packed]\n"
+                                "          [--rate exp:start:growth[:max]|time:rate,...] [--skip-to n]\n"
+                                "          [--headless WxH [--out -|frames/%%05d.png] [--fps n] [--per-frame n] [--frames n]]\n"
+                                "          [--poster WxH out.ppm [--tile n] [--poster-digits n]]\n"
+                                "          [--hud] [--profile out.csv|trace.json] [--presets presets.txt [--preset n]]\n"
+                                "          [--shader-cache dir|--no-shader-cache] [--startup]\n", argv[0]);
+                return 1;
+            }
+        }
+
+        profile::enabled.store(show_hud || profile_path, std::memory_order_relaxed);
+
+        return glsuccess;
+    }
+
+    int init_digits() {
+        if (digit_path) {
+            digit_file_t *file = new digit_file_t;
+            if (file->load(digit_path))
+                handle_error("Failed to load digit file");
+            digits = new padded_source_t(file);
+        } else {
+            pi_generator_t *generator = new pi_generator_t(1000000);
+            generator->start();
+            digits = new padded_source_t(generator);
+        }
+
+        // Convert the digits to a packed file and quit
+        if (pack_path) {
+            while (!digits->done())
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            if (digit_file_t::write_packed(pack_path, *digits))
+                handle_error("Failed to write packed digits");
+            safe_exit(0);
+        }
+
+        return glsuccess;
     }
 
     int init_context() {
+        if (headless_width || poster_path)
+            headless_init_hints();
+
         if (!glfwInit())
             handle_error("Failed to init glfw");
 
+        // Headless runs still need a context, just not one anybody sees
+        if (headless_width || poster_path)
+            headless_window_hints();
+
         window = glfwCreateWindow(800, 800, "Pi Day 2025", 0, 0);
 
         if (!window)
@@ -313,7 +353,8 @@ namespace program {
         glfwSetFramebufferSizeCallback(window, handle_buffersize);
         glfwSetCursorPosCallback(window, handle_cursorpos);
         glfwSetMouseButtonCallback(window, handle_mousebutton);
-        glfwSwapInterval(1);
+        glfwSetScrollCallback(window, handle_scroll);
+        glfwSwapInterval(headless_width || poster_path ? 0 : 1);
 
         signal(SIGINT, handle_signal);
 
@@ -327,14 +368,42 @@ namespace program {
     }
 
     int init() {
+        // Both are the same atlas, and it loads while the shaders link
+        text_texture = assets.texture("assets/text.png");
+        pi_texture = assets.texture("assets/text.png");
+        assets.start(window);
+
+        // The text and lod programs link through program_cache from their paths, see cached_program_t::load()
         text_vertex = new shader_t(GL_VERTEX_SHADER);
         text_fragment = new shader_t(GL_FRAGMENT_SHADER);
         text_program = new shader_text_program_t(shaderProgram_t(text_vertex, text_fragment));
-        text_texture = new texture_t;
-        pi_texture = new texture_t;
+        instanced_vertex = new shader_t(GL_VERTEX_SHADER);
+        instanced_program = new shader_text_program_t(shaderProgram_t(instanced_vertex, text_fragment));
+        packed_vertex = new shader_t(GL_VERTEX_SHADER);
+        packed_program = new shader_text_program_t(shaderProgram_t(packed_vertex, text_fragment));
+        dot_vertex = new shader_t(GL_VERTEX_SHADER);
+        dot_fragment = new shader_t(GL_FRAGMENT_SHADER);
+        dot_program = new cached_program_t(shaderProgram_t(dot_vertex, dot_fragment));
+        density_vertex = new shader_t(GL_VERTEX_SHADER);
+        density_fragment = new shader_t(GL_FRAGMENT_SHADER);
+        density_program = new cached_program_t(shaderProgram_t(density_vertex, density_fragment));
         circle_text = new ui_circle_text_t(window, text_program, text_texture, {-1.0,-1.0,1.0,1.0});
+        circle_text->instanced = instanced;
+        circle_text->instance_program = instanced_program;
+        circle_text->packed = packed;
+        circle_text->packed_program = packed_program;
+        circle_text->dot_program = dot_program;
+        circle_text->density_program = density_program;
         pi_image = new ui_image_t(window, {-1.0,-1.0,1.0,1.0});
 
+        // Before the sliders so they start from the preset
+        if (presets_path) {
+            if (preset_t::load(presets_path, presets))
+                handle_error("Failed to load presets");
+            preset = std::min(preset, presets.size() - 1);
+            apply_preset(presets[preset]);
+        }
+
         using st = ui_slider_t;
         using sv = st::ui_slider_v;
 
@@ -356,41 +425,59 @@ namespace program {
     }
 
     int load() {
-        if (text_vertex->load("shaders/text_vertex.glsl") ||
-            text_fragment->load("shaders/text_fragment.glsl"))
-            handle_error("Failed to load shaders");
-        
-        if (text_program->load())
+        if (text_program->load(program_cache, "shaders/text_vertex.glsl", "shaders/text_fragment.glsl"))
             handle_error("Failed to compile shaders");
 
-        if (text_texture->load("assets/text.png") ||
-            pi_texture->load("assets/text.png"))
-            handle_error("Failed to load assets");
+        if (instanced && instanced_program->load(program_cache, "shaders/text_instanced_vertex.glsl", "shaders/text_fragment.glsl"))
+            handle_error("Failed to compile instanced shaders");
+
+        if (packed && packed_program->load(program_cache, "shaders/text_packed_vertex.glsl", "shaders/text_fragment.glsl"))
+            handle_error("Failed to compile packed shaders");
+
+        if (dot_program->load(program_cache, "shaders/lod_dot_vertex.glsl", "shaders/lod_dot_fragment.glsl") ||
+            density_program->load(program_cache, "shaders/lod_density_vertex.glsl", "shaders/lod_density_fragment.glsl"))
+            handle_error("Failed to compile lod shaders");
+
+        assets.wait();
 
         pi_image->load();
         circle_text->load();
         ui_base->load();
 
 
-        circle_text->set_string("3.14");
+        circle_text->set_source(digits, 4);
+        schedule.base = circle_text->glyph_count();
+
+        // Build the spiral at skip_to in one go instead of playing up to it
+        if (skip_to) {
+            while (digits->size() < skip_to && !digits->done())
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            skip_to = std::min(skip_to, digits->size());
+            schedule.seek(skip_to);
+            circle_text->show(skip_to);
+        }
 
-        handle_buffersize(window, 800, 800);
+        if (profile_path && profile::profiler.open(profile_path))
+            handle_error("Failed to open profile file");
+
+        if (headless_width) {
+            headless = new headless_t(headless_width, headless_height);
+            if (headless->load(headless_out))
+                handle_error("Failed to create offscreen framebuffer");
+            // Every frame has to show exactly what the schedule says
+            circle_text->async = false;
+            handle_buffersize(window, headless_width, headless_height);
+        } else {
+            handle_buffersize(window, 800, 800);
+        }
 
         return glsuccess;
     }
-}
 
-int main() {
-    using namespace program;
-    if (init_context() || init() || load())
-        handle_error("Failed to start program");
-
-    while (!glfwWindowShouldClose(window)) {
+    void draw() {
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        program::handle_keyboard(window, 1/60);
-
         glEnable(GL_ALPHA_TEST);
         glDisable(GL_DEPTH_TEST);
         glEnable(GL_POLYGON_OFFSET_FILL);
@@ -398,15 +485,287 @@ int main() {
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-        text_program->use();
-        text_program->set_m4("projection", glm::mat4(1.0) * program::perspective_matrix);
+        glm::mat4 projection = program::perspective_matrix * camera.matrix();
+        circle_text->view = camera.view(program::perspective_matrix);
+        circle_text->pixel_scale = program::perspective_matrix[0][0] * camera.zoom * screen_size[0] * 0.5f;
+
+        {
+            profile::scope_t scope("uniforms");
+            for (shaderProgram_t *lod_program : {dot_program, density_program}) {
+                lod_program->use();
+                lod_program->set_m4("projection", projection);
+            }
+
+            if (instanced) {
+                instanced_program->mixFactor = text_program->mixFactor;
+                instanced_program->use();
+                instanced_program->set_m4("projection", projection);
+            }
+
+            if (packed) {
+                packed_program->mixFactor = text_program->mixFactor;
+                packed_program->use();
+                packed_program->set_m4("projection", projection);
+            }
+
+            text_program->use();
+            text_program->set_m4("projection", projection);
+        }
+
+        profile::gpu_scope_t scope("render");
         circle_text->render();
         //pi_image->render();
         //text_program->set_m4("projection", glm::mat4(1.0));
         //ui_base->render();
+    }
+
+    // Time from launch to the first finished frame, cold when any program had to be compiled
+    void report_first_frame() {
+        if (!first_frame)
+            return;
+        first_frame = false;
+
+        glFinish();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+        const char *start = !program_cache.enabled ? "uncached" : program_cache.misses ? "cold" : "warm";
+        fprintf(stderr, "First frame after %.1f ms, %s start (%i of %i programs from the cache, textures took %.1f ms)\n", ms, start,
+                program_cache.hits, program_cache.hits + program_cache.misses, assets.time * 1000);
+
+        if (startup_only)
+            safe_exit(0);
+    }
 
-        glfwSwapBuffers(window);
+    // Profiler summary in the top left, refreshed a few times a second so it stays readable
+    void render_hud() {
+        if (!show_hud)
+            return;
+
+        profile::scope_t scope("hud");
+
+        double now = glfwGetTime();
+        if (now - hud_time >= 0.25) {
+            hud_time = now;
+            std::vector<std::string> lines = profile::profiler.summary();
+            for (size_t i = hud_lines.size(); i < lines.size(); i++) {
+                hud_lines.push_back(new ui_text_t(window, text_program, text_texture, {-0.98, -0.98 + i * 0.05, 1.0, 0.05}));
+                hud_lines.back()->load();
+            }
+            for (size_t i = 0; i < hud_lines.size(); i++) {
+                hud_lines[i]->string_buffer = i < lines.size() ? lines[i] : "";
+                hud_lines[i]->modified = true;
+            }
+        }
+
+        text_program->use();
+        text_program->set_m4("projection", glm::mat4(1.0f));
+        for (ui_text_t *line : hud_lines)
+            line->render();
+    }
+
+    // Render the schedule as fast as possible into the offscreen target
+    int run_headless() {
+        auto start = std::chrono::steady_clock::now();
+        bool more = true;
+
+        while (more && !glfwWindowShouldClose(window) && (!max_frames || headless->frame_count() < max_frames)) {
+            profile::profiler.begin_frame();
+            {
+                profile::scope_t scope("advance");
+                more = advance(1.0 / headless_fps, true);
+            }
+
+            headless->bind();
+            draw();
+            {
+                profile::scope_t scope("capture");
+                if (headless->capture())
+                    handle_error("Failed to write frame");
+            }
+            report_first_frame();
+
+            glfwPollEvents();
+            profile::profiler.end_frame();
+        }
+
+        if (headless->finish())
+            handle_error("Failed to write frame");
+
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "%zu frames %ix%i in %.2fs (%.1f fps), %zu digits\n", headless->frame_count(),
+                headless_width, headless_height, time, headless->frame_count() / time, circle_text->glyph_count());
+
+        safe_exit(0);
+        return glsuccess;
+    }
+
+    // Render every digit into a poster of any size, one tile at a time
+    //
+    // Tiles are meshed in parallel, each with just the glyphs that reach into
+    // it, then drawn and read back in order on the GL thread and written out
+    // a band of tiles at a time.
+    int export_poster() {
+        while (!digits->done() && (!poster_digits || digits->size() < poster_digits))
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        circle_text->show(poster_digits ? std::min(poster_digits, digits->size()) : digits->size());
+
+        auto placed = std::make_unique<ui_circle_text_t::placement_t>();
+        circle_text->place(*placed);
+        const auto &p = *placed;
+        size_t count = p.radii.size();
+
+        // Glyphs by distance from the center, a tile only looks at the ring it overlaps
+        std::vector<uint32_t> by_dist(count);
+        std::vector<float> dist(count);
+        for (size_t i = 0; i < count; i++)
+            by_dist[i] = i;
+        std::sort(by_dist.begin(), by_dist.end(), [&](uint32_t a, uint32_t b) { return std::abs(p.radii[a]) < std::abs(p.radii[b]); });
+        for (size_t i = 0; i < count; i++)
+            dist[i] = std::abs(p.radii[by_dist[i]]);
+
+        float margin = 0, extent = 0;
+        for (size_t i = 0; i < count; i++) {
+            margin = std::max(margin, p.scales[i] * p.reach);
+            extent = std::max(extent, std::abs(p.radii[i]) + p.scales[i] * p.reach);
+        }
+
+        GLint max_size;
+        glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &max_size);
+        int tile = std::min(poster_tile, (int)max_size);
+        int cols = (poster_width + tile - 1) / tile;
+        int rows = (poster_height + tile - 1) / tile;
+
+        // Screen space has y going up, text_vertex.glsl flips it
+        float px = 2.02f * extent / std::min(poster_width, poster_height);
+        glm::vec2 center(p.center[0], -p.center[1]);
+        float left = center[0] - poster_width * px * 0.5f;
+        float top = center[1] + poster_height * px * 0.5f;
+
+        // left, bottom, right, top
+        auto tile_rect = [&](size_t k) {
+            float x = left + (k % cols) * tile * px;
+            float y = top - (k / cols) * tile * px;
+            return glm::vec4(x, y - tile * px, x + tile * px, y);
+        };
+
+        auto mesh_tile = [&](size_t k) {
+            glm::vec4 r = tile_rect(k);
+
+            glm::vec2 nearest(std::clamp(center[0], r[0], r[2]), std::clamp(center[1], r[1], r[3]));
+            float near = glm::length(nearest - center);
+            float far = 0;
+            for (int c = 0; c < 4; c++)
+                far = std::max(far, glm::length(glm::vec2(r[c & 1 ? 2 : 0], r[c & 2 ? 3 : 1]) - center));
+
+            size_t lo = std::lower_bound(dist.begin(), dist.end(), near - margin) - dist.begin();
+            size_t hi = std::upper_bound(dist.begin(), dist.end(), far + margin) - dist.begin();
+
+            std::vector<uint32_t> ids;
+            for (size_t j = lo; j < hi; j++) {
+                uint32_t i = by_dist[j];
+                float x = p.radii[i] * sin(p.angles[i]) + center[0];
+                float y = p.radii[i] * cos(p.angles[i]) + center[1];
+                float e = p.scales[i] * p.reach;
+                if (x + e >= r[0] && x - e <= r[2] && y + e >= r[1] && y - e <= r[3])
+                    ids.push_back(i);
+            }
+            // Keep the spiral's draw order where glyphs overlap
+            std::sort(ids.begin(), ids.end());
+
+            std::vector<text_t> verticies;
+            ui_circle_text_t::mesh_placed(p, ids, verticies);
+            return verticies;
+        };
+
+        stripe_writer_t out;
+        if (out.open(poster_path, poster_width, poster_height))
+            handle_error("Failed to open poster file");
+
+        std::vector<uint8_t> stripe((size_t)poster_width * tile * 3);
+        size_t drained = 0;
+
+        // Crop the tile into its band, write the band once its last tile is in
+        headless_t target(tile, tile);
+        auto sink = [&](const uint8_t *pixels) {
+            size_t k = drained++;
+            int x0 = (k % cols) * tile, y0 = (k / cols) * tile;
+            int w = std::min(tile, poster_width - x0), h = std::min(tile, poster_height - y0);
+
+            for (int y = 0; y < h; y++) {
+                const uint8_t *src = &pixels[(size_t)(tile - 1 - y) * tile * 4];
+                uint8_t *dst = &stripe[((size_t)y * poster_width + x0) * 3];
+                for (int x = 0; x < w; x++)
+                    memcpy(&dst[x * 3], &src[x * 4], 3);
+            }
+
+            if ((int)(k % cols) == cols - 1) {
+                fprintf(stderr, "\rposter row %zu/%i", k / cols + 1, rows);
+                return out.write(stripe.data(), h);
+            }
+            return (int)glsuccess;
+        };
+        if (target.load(sink))
+            handle_error("Failed to create tile framebuffer");
+
+        unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+        ordered_pool_t<std::vector<text_t>> pool(cols * rows, threads * 2, mesh_tile, threads);
+
+        for (size_t k = 0; k < (size_t)cols * rows; k++) {
+            circle_text->render_placed(pool.take(k));
+
+            glm::vec4 r = tile_rect(k);
+            perspective_matrix = glm::ortho(r[0], r[2], r[1], r[3]);
+            target.bind();
+            draw();
+
+            if (target.capture())
+                handle_error("Failed to write poster");
+        }
+
+        if (target.finish() || out.close())
+            handle_error("Failed to write poster");
+
+        fprintf(stderr, "\n%ix%i poster of %zu digits in %ix%i tiles\n", poster_width, poster_height, count, cols, rows);
+
+        safe_exit(0);
+        return glsuccess;
+    }
+}
+
+int main(int argc, char **argv) {
+    using namespace program;
+    if (parse_args(argc, argv) || init_digits())
+        return 1;
+
+    if (init_context() || init() || load())
+        handle_error("Failed to start program");
+
+    if (poster_path)
+        return export_poster();
+
+    if (headless)
+        return run_headless();
+
+    double last_time = glfwGetTime();
+    while (!glfwWindowShouldClose(window)) {
+        profile::profiler.begin_frame();
+
+        double now = glfwGetTime();
+        {
+            profile::scope_t scope("input");
+            program::handle_keyboard(window, now - last_time);
+        }
+        last_time = now;
+        draw();
+        render_hud();
+
+        {
+            profile::scope_t scope("swap");
+            glfwSwapBuffers(window);
+        }
+        report_first_frame();
         glfwPollEvents();
+
+        profile::profiler.end_frame();
     }
 
     safe_exit(0);
@@ -422,6 +781,13 @@ void reset() {
 }
 
 void destroy() {
+    if (profile::profiler.close())
+        fprintf(stderr, "Failed to write profile\n");
+    delete program::headless;
+    // The mesh worker may still be reading digits
+    if (program::circle_text)
+        program::circle_text->stop_worker();
+    delete program::digits;
     glfwTerminate();
 }
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// Runs the most recently submitted job on a background thread
+//
+// Jobs and results are handed over through single slot mailboxes with one
+// producer and one consumer each. A newer job replaces one the worker
+// hasn't picked up yet and a newer result replaces one the render thread
+// hasn't taken yet, so only the latest request is ever built.
+template<typename job_t, typename result_t>
+struct mesh_worker_t {
+    using build_t = std::function<result_t(const job_t &)>;
+
+    mesh_worker_t(build_t build)
+    :build(build), worker(&mesh_worker_t::run, this) {}
+
+    ~mesh_worker_t() {
+        stop = true;
+        wake();
+        worker.join();
+        delete pending.exchange(nullptr);
+        delete ready.exchange(nullptr);
+    }
+
+    void submit(job_t job) {
+        delete pending.exchange(new job_t(std::move(job)));
+        wake();
+    }
+
+    // Take the latest finished result, if any
+    bool poll(result_t &out) {
+        result_t *result = ready.exchange(nullptr);
+        if (!result)
+            return false;
+        out = std::move(*result);
+        delete result;
+        return true;
+    }
+
+    protected:
+    void wake() {
+        posted.fetch_add(1);
+        posted.notify_one();
+    }
+
+    void run() {
+        while (true) {
+            uint32_t seen = posted.load();
+
+            job_t *job = pending.exchange(nullptr);
+            if (job) {
+                result_t *result = new result_t(build(*job));
+                delete job;
+                delete ready.exchange(result);
+                continue;
+            }
+
+            if (stop)
+                break;
+
+            posted.wait(seen);
+        }
+    }
+
+    build_t build;
+    std::atomic<job_t*> pending = nullptr;
+    std::atomic<result_t*> ready = nullptr;
+    std::atomic<uint32_t> posted = 0;
+    std::atomic<bool> stop = false;
+    std::thread worker;
+};
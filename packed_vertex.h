@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "common.h"
+#include "text.h"
+
+// Quantized stand in for text_t on the vertex path
+//
+// Positions are 16 bit fractions of a box around the spiral, atlas coords 16
+// bit and the rest of the text_t texture vec4 (which text_fragment.glsl also
+// mixes in as a color) 8 bit. 4 verticies per glyph share a 16 bit index
+// buffer, 48 bytes a glyph instead of 144. shaders/text_packed_vertex.glsl
+// rebuilds the vec4 from tex and color's last two, for text_fragment.glsl.
+struct packed_vertex_t {
+    uint16_t pos[2];
+    uint16_t tex[2];
+    uint8_t color[4];
+
+    // Glyphs per draw, so quad indices fit in 16 bits
+    static constexpr size_t max_quads = 16384;
+
+    // Which of the 4 packed corners each of add_rect's 6 verticies is
+    struct quad_t {
+        int first[4];  // first of the 6 at each corner
+        uint16_t index[6];
+    };
+
+    void set_attrib_pointers() const {
+        glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(packed_vertex_t), (void*)offsetof(packed_vertex_t, pos));
+        glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(packed_vertex_t), (void*)offsetof(packed_vertex_t, tex));
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(packed_vertex_t), (void*)offsetof(packed_vertex_t, color));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+        // Part of the VAO, every packed buffer draws through the same indices
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer());
+    }
+
+    static GLuint index_buffer() {
+        static GLuint buffer = 0;
+        if (buffer)
+            return buffer;
+
+        quad_t q = pattern;
+        std::vector<uint16_t> indices(max_quads * 6);
+        for (size_t i = 0; i < max_quads; i++)
+            for (int k = 0; k < 6; k++)
+                indices[i * 6 + k] = i * 4 + q.index[k];
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+        return buffer;
+    }
+
+    // Find the quad in one glyph's 6 corners (x, y pairs), false unless there are exactly 4
+    static bool find_quad(const float *corners, quad_t &q) {
+        int found = 0;
+        for (int k = 0; k < 6; k++) {
+            int c = 0;
+            while (c < found && memcmp(&corners[q.first[c] * 2], &corners[k * 2], sizeof(float) * 2))
+                c++;
+            if (c == found) {
+                if (found == 4)
+                    return false;
+                q.first[found++] = k;
+            }
+            q.index[k] = c;
+        }
+        return found == 4;
+    }
+
+    // add_rect winds every glyph the same way, the index buffer is built once from the first pattern
+    static inline quad_t pattern;
+    static inline bool have_pattern = false;
+
+    static bool set_pattern(const float *corners) {
+        quad_t q;
+        if (!find_quad(corners, q))
+            return false;
+        if (have_pattern)
+            return !memcmp(&q, &pattern, sizeof q);
+        pattern = q;
+        have_pattern = true;
+        return true;
+    }
+
+    static uint16_t unorm16(float v) {
+        return std::clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f;
+    }
+
+    static uint8_t unorm8(float v) {
+        return std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f;
+    }
+
+    // Pack glyphs of 6 text_t each into 4 verticies each, box is min x, min y, max x, max y
+    static void pack(const text_t *in, size_t glyphs, const glm::vec4 &box, packed_vertex_t *out) {
+        glm::vec2 lo(box[0], box[1]);
+        glm::vec2 scale(1.0f / (box[2] - box[0]), 1.0f / (box[3] - box[1]));
+
+        for (size_t i = 0; i < glyphs; i++) {
+            for (int c = 0; c < 4; c++) {
+                const text_t &v = in[i * 6 + pattern.first[c]];
+                float f[6];
+                memcpy(f, &v, sizeof f);
+
+                packed_vertex_t &p = out[i * 4 + c];
+                p.pos[0] = unorm16((f[0] - lo[0]) * scale[0]);
+                p.pos[1] = unorm16((f[1] - lo[1]) * scale[1]);
+                p.tex[0] = unorm16(f[2]);
+                p.tex[1] = unorm16(f[3]);
+                for (int k = 0; k < 4; k++)
+                    p.color[k] = unorm8(f[2 + k]);
+            }
+        }
+    }
+
+    // Every position of count text_t verticies lies in box
+    static bool inside(const text_t *in, size_t count, const glm::vec4 &box) {
+        for (size_t i = 0; i < count; i++) {
+            float f[2];
+            memcpy(f, &in[i], sizeof f);
+            if (f[0] < box[0] || f[1] < box[1] || f[0] > box[2] || f[1] > box[3])
+                return false;
+        }
+        return true;
+    }
+};
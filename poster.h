@@ -0,0 +1,115 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// Runs job(0) .. job(count - 1) on a pool of threads and hands the results
+// back strictly in order
+//
+// At most ahead results are built past the one the consumer is waiting on,
+// so a slow consumer bounds the memory in flight.
+template<typename result_t>
+struct ordered_pool_t {
+    using job_t = std::function<result_t(size_t)>;
+
+    ordered_pool_t(size_t count, size_t ahead, job_t job, unsigned threads = std::thread::hardware_concurrency())
+    :count(count), ahead(std::max<size_t>(ahead, 1)), job(job) {
+        for (unsigned i = 0; i < std::max(threads, 1u); i++)
+            workers.emplace_back(&ordered_pool_t::run, this);
+    }
+
+    ~ordered_pool_t() {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        changed.notify_all();
+        for (auto &w : workers)
+            w.join();
+    }
+
+    // Wait for the result of job(i), i has to go up by one every call
+    result_t take(size_t i) {
+        std::unique_lock lock(mutex);
+        changed.wait(lock, [&]{ return done.count(i); });
+        result_t res = std::move(done[i]);
+        done.erase(i);
+        taken = i + 1;
+        changed.notify_all();
+        return res;
+    }
+
+    protected:
+    void run() {
+        std::unique_lock lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]{ return stop || next >= count || next < taken + ahead; });
+            if (stop || next >= count)
+                break;
+
+            size_t i = next++;
+            lock.unlock();
+            result_t res = job(i);
+            lock.lock();
+
+            done[i] = std::move(res);
+            changed.notify_all();
+        }
+    }
+
+    size_t count, ahead;
+    job_t job;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t next = 0, taken = 0;
+    std::map<size_t, result_t> done;
+    bool stop = false;
+    std::vector<std::thread> workers;
+};
+
+// Binary PPM written a band of rows at a time, top to bottom
+//
+// Only the band being assembled has to be in memory, which keeps posters
+// far bigger than any framebuffer (or RAM) writable.
+struct stripe_writer_t {
+    ~stripe_writer_t() {
+        close();
+    }
+
+    int open(const char *path, int width, int height) {
+        this->width = width;
+        this->height = height;
+        file = fopen(path, "wb");
+        if (!file)
+            return 1;
+        if (fprintf(file, "P6 %i %i 255\n", width, height) < 0)
+            return 1;
+        return glsuccess;
+    }
+
+    // rows full width RGB rows
+    int write(const uint8_t *rgb, int rows) {
+        size_t size = (size_t)width * 3 * rows;
+        if (fwrite(rgb, 1, size, file) != size)
+            return 1;
+        written += rows;
+        return glsuccess;
+    }
+
+    int close() {
+        if (!file)
+            return glsuccess;
+        int ret = fclose(file) || written != height;
+        file = nullptr;
+        return ret ? 1 : glsuccess;
+    }
+
+    protected:
+    FILE *file = nullptr;
+    int width = 0, height = 0;
+    int written = 0;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+// Slider settings for the circle text spiral, written by explore.cpp
+//
+// One preset a line, '#' starts a comment. The scores are what explore.cpp
+// measured at the digit count in the header and are only there to read.
+struct preset_t {
+    float char_scale, base_chars, base_center_dist, base_angle, radii_scale_1, radii_scale_2;
+    bool reverse_dir;
+
+    float fill = 0, min_px = 0, overlap = 0;
+
+    static constexpr const char *columns = "# scale chars center angle radii_scale_1 radii_scale_2 reverse  fill min_px overlap\n";
+
+    // Returns true on failure, like digit_file_t
+    static bool load(const char *path, std::vector<preset_t> &out) {
+        FILE *f = fopen(path, "r");
+        if (!f)
+            return true;
+
+        char line[512];
+        bool bad = false;
+        while (fgets(line, sizeof line, f)) {
+            char *s = line + strspn(line, " \t");
+            if (*s == '#' || *s == '\n' || !*s)
+                continue;
+
+            preset_t p;
+            int reverse;
+            int n = sscanf(s, "%f %f %f %f %f %f %i %f %f %f", &p.char_scale, &p.base_chars, &p.base_center_dist, &p.base_angle,
+                           &p.radii_scale_1, &p.radii_scale_2, &reverse, &p.fill, &p.min_px, &p.overlap);
+            if (n < 7 || p.base_chars <= 0) {
+                bad = true;
+                break;
+            }
+            p.reverse_dir = reverse;
+            out.push_back(p);
+        }
+
+        fclose(f);
+        return bad || out.empty();
+    }
+
+    static bool write(const char *path, const char *header, const std::vector<preset_t> &presets) {
+        FILE *f = fopen(path, "w");
+        if (!f)
+            return true;
+
+        bool bad = fputs(header, f) < 0 || fputs(columns, f) < 0;
+        for (auto &p : presets)
+            bad |= fprintf(f, "%.5f %.3f %.5f %.5f %.5f %.5f %i  %.4f %.3f %.4f\n", p.char_scale, p.base_chars, p.base_center_dist,
+                           p.base_angle, p.radii_scale_1, p.radii_scale_2, (int)p.reverse_dir, p.fill, p.min_px, p.overlap) < 0;
+
+        return fclose(f) || bad;
+    }
+};
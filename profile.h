@@ -0,0 +1,339 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+// Where the time in a frame goes
+//
+// scope_t times a block on the CPU, gpu_scope_t also brackets it with a
+// GL_TIME_ELAPSED query. Queries alternate between two sets, one per frame,
+// and a frame's set is only read a frame later once GL_QUERY_RESULT_AVAILABLE
+// says so, so the profiler never waits on the GPU it is measuring. Finished
+// frames feed summary() for the HUD and, with open(), a CSV or a trace event
+// JSON for about://tracing. While enabled is false a scope is one branch.
+namespace profile {
+    // Set on the main thread, read by scopes on the mesh worker too
+    inline std::atomic<bool> enabled = false;
+
+    inline bool on() { return enabled.load(std::memory_order_relaxed); }
+
+    struct stat_t {
+        enum kind_t { cpu, gpu, counter };
+
+        const char *name; // string literal, matched by pointer
+        kind_t kind;
+        double value;     // ms for cpu and gpu, a total for counters
+        int calls;
+    };
+
+    struct event_t {
+        const char *name;
+        double start_us, dur_us;
+        int tid; // 0 for the gpu
+    };
+
+    struct frame_t {
+        uint64_t index = 0;
+        double start_us = 0, dur_us = 0;
+        std::vector<stat_t> stats;
+        std::vector<event_t> events;
+
+        // GL_TIME_ELAPSED queries, kept between frames and reused
+        std::vector<GLuint> queries;
+        std::vector<event_t> query_events;
+        bool pending = false;
+
+        void add(const char *name, stat_t::kind_t kind, double v) {
+            for (auto &s : stats) {
+                if (s.name == name && s.kind == kind) {
+                    s.value += v;
+                    s.calls++;
+                    return;
+                }
+            }
+            stats.push_back({name, kind, v, 1});
+        }
+    };
+
+    struct profiler_t {
+        // .json writes trace events, anything else CSV
+        int open(const char *path) {
+            trace = strlen(path) > 5 && !strcmp(path + strlen(path) - 5, ".json");
+            file = fopen(path, "w");
+            if (!file)
+                return 1;
+            if (fputs(trace ? "[\n" : "frame,start_ms,frame_ms,kind,name,value,calls\n", file) < 0)
+                return 1;
+            return glsuccess;
+        }
+
+        // Flush the frames still waiting on their queries and close the file
+        int close() {
+            for (int i = 1; i <= 2; i++) {
+                frame_t &f = frames[(index + i) % 2];
+                if (f.pending)
+                    resolve(f, true);
+            }
+
+            if (!file)
+                return glsuccess;
+            if (trace)
+                fputs("\n]\n", file);
+            int ret = fclose(file);
+            file = nullptr;
+            return ret ? 1 : glsuccess;
+        }
+
+        double now_us() const {
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch).count();
+        }
+
+        void begin_frame() {
+            if (!on())
+                return;
+
+            std::lock_guard lock(mutex);
+            frame_t &f = frames[index % 2];
+            f.index = index;
+            f.start_us = now_us();
+            f.stats.clear();
+            f.events.clear();
+            f.query_events.clear();
+            in_frame = true;
+        }
+
+        // Read back the previous frame's queries if they are done and hand it on
+        void end_frame() {
+            if (!in_frame)
+                return;
+
+            // Headless frames never swap, make sure this frame's queries reach the GPU
+            if (!frames[index % 2].query_events.empty())
+                glFlush();
+
+            frame_t *prev;
+            {
+                std::lock_guard lock(mutex);
+                frame_t &f = frames[index % 2];
+                f.dur_us = now_us() - f.start_us;
+                f.pending = true;
+                in_frame = false;
+                index++;
+                prev = &frames[index % 2];
+            }
+
+            if (prev->pending)
+                resolve(*prev, false);
+        }
+
+        void cpu(const char *name, double start_us, double dur_us) {
+            std::lock_guard lock(mutex);
+            frame_t &f = frames[index % 2];
+            f.add(name, stat_t::cpu, dur_us * 1e-3);
+            if (file && trace)
+                f.events.push_back({name, start_us, dur_us, thread_id()});
+        }
+
+        void count(const char *name, double v) {
+            std::lock_guard lock(mutex);
+            frames[index % 2].add(name, stat_t::counter, v);
+        }
+
+        // GL thread only, returns false when a query can't start (one is already running)
+        bool begin_query(const char *name, double start_us) {
+            if (!in_frame || query_active)
+                return false;
+
+            frame_t &f = frames[index % 2];
+            size_t i = f.query_events.size();
+            if (i == f.queries.size()) {
+                GLuint q;
+                glGenQueries(1, &q);
+                f.queries.push_back(q);
+            }
+
+            f.query_events.push_back({name, start_us, 0, 0});
+            glBeginQuery(GL_TIME_ELAPSED, f.queries[i]);
+            query_active = true;
+            return true;
+        }
+
+        void end_query() {
+            glEndQuery(GL_TIME_ELAPSED);
+            query_active = false;
+        }
+
+        // Per frame averages since the last call, one line each
+        std::vector<std::string> summary() {
+            std::vector<std::string> lines;
+            if (!averaged)
+                return lines;
+
+            char buf[128];
+            snprintf(buf, sizeof buf, "frame %8.2f ms  %.0f fps", average_frame_us * 1e-3 / averaged, averaged / (average_frame_us * 1e-6));
+            lines.push_back(buf);
+
+            const char *kinds[] = {"cpu", "gpu", ""};
+            for (auto &s : average) {
+                if (s.kind == stat_t::counter)
+                    snprintf(buf, sizeof buf, "%-14s %12.0f", s.name, s.value / averaged);
+                else
+                    snprintf(buf, sizeof buf, "%-14s %8.3f ms %s", s.name, s.value / averaged, kinds[s.kind]);
+                lines.push_back(buf);
+            }
+
+            if (late)
+                lines.push_back("gpu results late on " + std::to_string(late) + " frames");
+
+            average.clear();
+            average_frame_us = 0;
+            averaged = 0;
+            late = 0;
+
+            return lines;
+        }
+
+        protected:
+        static int thread_id() {
+            static std::atomic<int> next = 1;
+            thread_local int id = next++;
+            return id;
+        }
+
+        void resolve(frame_t &f, bool wait) {
+            f.pending = false;
+            size_t n = f.query_events.size();
+
+            GLint available = 1;
+            if (n > 0 && !wait)
+                glGetQueryObjectiv(f.queries[n - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+            // Results land in order, the last one being ready means they all are
+            if (available) {
+                for (size_t i = 0; i < n; i++) {
+                    GLuint64 ns;
+                    glGetQueryObjectui64v(f.queries[i], GL_QUERY_RESULT, &ns);
+                    event_t &e = f.query_events[i];
+                    e.dur_us = ns * 1e-3;
+                    f.add(e.name, stat_t::gpu, e.dur_us * 1e-3);
+                    // The GPU has no shared clock here, line it up with the CPU side
+                    f.events.push_back(e);
+                }
+            } else {
+                late++;
+            }
+
+            emit(f);
+        }
+
+        void emit(const frame_t &f) {
+            for (auto &s : f.stats) {
+                bool found = false;
+                for (auto &a : average) {
+                    if (a.name == s.name && a.kind == s.kind) {
+                        a.value += s.value;
+                        a.calls += s.calls;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found)
+                    average.push_back(s);
+            }
+            average_frame_us += f.dur_us;
+            averaged++;
+
+            if (!file)
+                return;
+
+            if (!trace) {
+                const char *kinds[] = {"cpu", "gpu", "count"};
+                fprintf(file, "%llu,%.3f,%.3f,frame,frame,%.4f,1\n", (unsigned long long)f.index, f.start_us * 1e-3, f.dur_us * 1e-3, f.dur_us * 1e-3);
+                for (auto &s : f.stats)
+                    fprintf(file, "%llu,%.3f,%.3f,%s,%s,%.4f,%i\n", (unsigned long long)f.index, f.start_us * 1e-3, f.dur_us * 1e-3,
+                            kinds[s.kind], s.name, s.value, s.calls);
+                return;
+            }
+
+            event_t frame = {"frame", f.start_us, f.dur_us, 1};
+            write_event(frame);
+            for (auto &e : f.events)
+                write_event(e);
+            for (auto &s : f.stats) {
+                if (s.kind != stat_t::counter)
+                    continue;
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%.0f}}", s.name, f.start_us, s.value);
+            }
+        }
+
+        void write_event(const event_t &e) {
+            fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%i}",
+                    written++ ? ",\n" : "", e.name, e.start_us, e.dur_us, e.tid);
+        }
+
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        std::mutex mutex;
+        frame_t frames[2];
+        uint64_t index = 0;
+        bool in_frame = false;
+        bool query_active = false;
+
+        FILE *file = nullptr;
+        bool trace = false;
+        size_t written = 0;
+
+        std::vector<stat_t> average;
+        double average_frame_us = 0;
+        int averaged = 0;
+        int late = 0;
+    };
+
+    inline profiler_t profiler;
+
+    // Time the enclosing block
+    struct scope_t {
+        scope_t(const char *name):name(name) {
+            if (on())
+                start = profiler.now_us();
+        }
+
+        ~scope_t() {
+            if (start >= 0)
+                profiler.cpu(name, start, profiler.now_us() - start);
+        }
+
+        const char *name;
+        double start = -1;
+    };
+
+    // Time the enclosing block on the CPU and its GL commands on the GPU, GL thread only
+    //
+    // GL_TIME_ELAPSED queries can't nest, inside another gpu_scope_t this only times the CPU.
+    struct gpu_scope_t : public scope_t {
+        gpu_scope_t(const char *name):scope_t(name) {
+            if (start >= 0)
+                query = profiler.begin_query(name, start);
+        }
+
+        ~gpu_scope_t() {
+            if (query)
+                profiler.end_query();
+        }
+
+        bool query = false;
+    };
+
+    inline void count(const char *name, double v) {
+        if (on())
+            profiler.count(name, v);
+    }
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+// Linked programs saved with glGetProgramBinary and loaded back on the next start
+//
+// Entries are keyed by a hash of the driver strings and both shader sources,
+// so an edited shader or an updated driver just misses. A binary the driver
+// turns down anyway gets compiled from source and replaced.
+struct program_cache_t {
+    const char *dir = "shader_cache";
+    bool enabled = true;
+    int hits = 0, misses = 0;
+
+    // Program from vertex_path and fragment_path, 0 on failure with the log on stderr
+    GLuint link(const char *vertex_path, const char *fragment_path) {
+        std::string vertex, fragment;
+        if (read_file(vertex_path, vertex) || read_file(fragment_path, fragment)) {
+            fprintf(stderr, "Failed to read %s or %s\n", vertex_path, fragment_path);
+            return 0;
+        }
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        bool cached = enabled && formats > 0;
+
+        std::string path;
+        if (cached) {
+            path = entry(vertex, fragment);
+            if (GLuint program = load_binary(path)) {
+                hits++;
+                return program;
+            }
+        }
+
+        misses++;
+        GLuint program = compile(vertex, vertex_path, fragment, fragment_path);
+        if (program && cached)
+            save_binary(path, program);
+        return program;
+    }
+
+    protected:
+    struct header_t {
+        char magic[8];
+        uint32_t format;
+        uint32_t size;
+    };
+
+    static constexpr char magic[8] = {'p', 'i', 'p', 'r', 'o', 'g', '0', '1'};
+
+    static bool read_file(const char *path, std::string &out) {
+        FILE *f = fopen(path, "rb");
+        if (!f)
+            return true;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof buf, f)) > 0)
+            out.append(buf, n);
+        bool bad = ferror(f);
+        fclose(f);
+        return bad;
+    }
+
+    // FNV-1a, only has to tell sources apart
+    static uint64_t hash(const std::string &s, uint64_t h) {
+        for (unsigned char c : s)
+            h = (h ^ c) * 1099511628211ull;
+        return h;
+    }
+
+    std::string entry(const std::string &vertex, const std::string &fragment) const {
+        uint64_t h = 14695981039346656037ull;
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION}) {
+            const char *s = (const char*)glGetString(name);
+            h = hash(std::string(s ? s : "") + '\n', h);
+        }
+        h = hash(vertex, h);
+        h = hash(std::string(1, '\0'), h);
+        h = hash(fragment, h);
+
+        char name[32];
+        snprintf(name, sizeof name, "/%016llx.bin", (unsigned long long)h);
+        return dir + std::string(name);
+    }
+
+    GLuint load_binary(const std::string &path) {
+        FILE *f = fopen(path.c_str(), "rb");
+        if (!f)
+            return 0;
+
+        header_t h;
+        std::vector<char> data;
+        bool ok = fread(&h, sizeof h, 1, f) == 1 && !memcmp(h.magic, magic, sizeof magic);
+        if (ok) {
+            data.resize(h.size);
+            ok = fread(data.data(), 1, h.size, f) == h.size;
+        }
+        fclose(f);
+        if (!ok)
+            return 0;
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, h.format, data.data(), data.size());
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    // Written next to the entry and renamed over it, a crash never leaves half a binary
+    void save_binary(const std::string &path, GLuint program) {
+        GLint size = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+        if (size <= 0)
+            return;
+
+        header_t h;
+        memcpy(h.magic, magic, sizeof magic);
+        std::vector<char> data(size);
+        GLsizei length = 0;
+        GLenum format;
+        glGetProgramBinary(program, size, &length, &format, data.data());
+        h.format = format;
+        h.size = length;
+
+        mkdir(dir, 0755);
+        std::string tmp = path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            return;
+        bool ok = fwrite(&h, sizeof h, 1, f) == 1 && fwrite(data.data(), 1, length, f) == (size_t)length;
+        if (fclose(f) || !ok || rename(tmp.c_str(), path.c_str()))
+            remove(tmp.c_str());
+    }
+
+    static GLuint compile(GLenum type, const std::string &src, const char *path) {
+        GLuint shader = glCreateShader(type);
+        const char *s = src.c_str();
+        glShaderSource(shader, 1, &s, nullptr);
+        glCompileShader(shader);
+
+        GLint ok = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+        if (!ok) {
+            char log[2048];
+            glGetShaderInfoLog(shader, sizeof log, nullptr, log);
+            fprintf(stderr, "%s: %s\n", path, log);
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    GLuint compile(const std::string &vertex, const char *vertex_path, const std::string &fragment, const char *fragment_path) {
+        GLuint vs = compile(GL_VERTEX_SHADER, vertex, vertex_path);
+        GLuint fs = compile(GL_FRAGMENT_SHADER, fragment, fragment_path);
+        if (!vs || !fs) {
+            glDeleteShader(vs);
+            glDeleteShader(fs);
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        // Some drivers only keep a binary around when asked before linking
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, vs);
+        glAttachShader(program, fs);
+        glLinkProgram(program);
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+
+        GLint ok = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            char log[2048];
+            glGetProgramInfoLog(program, sizeof log, nullptr, log);
+            fprintf(stderr, "%s + %s: %s\n", vertex_path, fragment_path, log);
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+// How many digits have arrived after some seconds of playback
+//
+// The rate in digits per second is either keyframed, ramping linearly
+// between keys and holding after the last one, or exponential from a start
+// rate up to a cap. Arrivals come from the integral of the rate, so the
+// same time shows the same digits whatever the frame rate.
+struct ingest_schedule_t {
+    struct key_t {
+        double time;
+        double rate;
+    };
+
+    std::vector<key_t> keys = tiers();
+    double growth = 0;   // exponential when > 0, rate = keys[0].rate * growth^t
+    double max_rate = 0; // cap for the exponential rate, 0 for none
+
+    double time = 0;
+    size_t base = 0; // digits shown when playback started
+
+    // The old per frame steps at 60 fps: 1 digit up to 100, then 2, 3, 4, 10 and 30
+    static std::vector<key_t> tiers() {
+        const double fps = 60;
+        const double until[] = {100, 500, 3000, 8000, 16000};
+        const double per_frame[] = {1, 2, 3, 4, 10, 30};
+
+        std::vector<key_t> k = {{0, per_frame[0] * fps}};
+        double t = 0, p = 0;
+        for (int i = 0; i < 5; i++) {
+            t += (until[i] - p) / (per_frame[i] * fps);
+            p = until[i];
+            k.push_back({t, per_frame[i] * fps});
+            k.push_back({t, per_frame[i + 1] * fps});
+        }
+        return k;
+    }
+
+    // "exp:start:growth[:max]" or "time:rate,time:rate,..."
+    int parse(const char *spec) {
+        if (!strncmp(spec, "exp:", 4)) {
+            double start;
+            max_rate = 0;
+            if (sscanf(spec + 4, "%lf:%lf:%lf", &start, &growth, &max_rate) < 2 || start <= 0 || growth <= 1)
+                return 1;
+            keys = {{0, start}};
+            return glsuccess;
+        }
+
+        growth = 0;
+        keys.clear();
+        for (const char *s = spec; *s; ) {
+            key_t k;
+            int used;
+            if (sscanf(s, "%lf:%lf%n", &k.time, &k.rate, &used) != 2 || k.rate < 0)
+                return 1;
+            if (!keys.empty() && k.time < keys.back().time)
+                return 1;
+            keys.push_back(k);
+            s += used;
+            if (*s == ',')
+                s++;
+            else if (*s)
+                return 1;
+        }
+        return keys.empty() ? 1 : glsuccess;
+    }
+
+    // Digits arrived after t seconds
+    double total(double t) const {
+        if (growth > 0) {
+            double start = keys[0].rate, k = log(growth);
+            double cap = max_rate > start ? log(max_rate / start) / k : INFINITY;
+            if (t <= cap)
+                return start * (exp(k * t) - 1) / k;
+            return start * (exp(k * cap) - 1) / k + max_rate * (t - cap);
+        }
+
+        double sum = 0;
+        if (t < keys[0].time)
+            return keys[0].rate * t;
+        sum += keys[0].rate * keys[0].time;
+
+        for (size_t i = 0; i + 1 < keys.size(); i++) {
+            const key_t &a = keys[i], &b = keys[i + 1];
+            if (t <= a.time)
+                return sum;
+            double end = std::min(t, b.time);
+            if (end > a.time) {
+                double rate_end = a.rate + (b.rate - a.rate) * (end - a.time) / (b.time - a.time);
+                sum += (a.rate + rate_end) * 0.5 * (end - a.time);
+            }
+            if (t <= b.time)
+                return sum;
+        }
+
+        return sum + keys.back().rate * (t - keys.back().time);
+    }
+
+    // Time at which digits have arrived, the rate never goes negative so total() only grows
+    double time_for(double digits) const {
+        double lo = 0, hi = 1;
+        while (total(hi) < digits && hi < 1e9)
+            hi *= 2;
+        for (int i = 0; i < 64; i++) {
+            double mid = (lo + hi) * 0.5;
+            if (total(mid) < digits)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        return hi;
+    }
+
+    // Play dt more seconds, returns the digits that should be showing
+    size_t step(double dt) {
+        time += dt;
+        return base + (size_t)(total(time) + 1e-6);
+    }
+
+    // Jump straight to digits shown, later steps carry on from there
+    void seek(size_t digits) {
+        time = digits > base ? time_for(digits - base) : 0;
+    }
+};
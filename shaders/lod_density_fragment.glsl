@@ -0,0 +1,19 @@
+#version 330 core
+
+in vec2 UV;
+in vec2 Pos;
+
+out vec4 color;
+
+uniform sampler2D density;
+uniform vec2 center;
+uniform vec2 band; // radii range drawn from the density texture
+
+void main()
+{
+    float r = distance(Pos, center);
+    if (r < band.x || r > band.y)
+        discard;
+
+    color = vec4(0.0, 0.0, 0.0, clamp(texture(density, UV).r, 0.0, 1.0));
+}
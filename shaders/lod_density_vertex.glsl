@@ -0,0 +1,16 @@
+#version 330 core
+
+const vec2 corners[4] = vec2[](vec2(0, 0), vec2(1, 0), vec2(0, 1), vec2(1, 1));
+
+out vec2 UV;
+out vec2 Pos;
+
+uniform mat4 projection;
+uniform vec4 rect; // min x, min y, max x, max y
+
+void main()
+{
+    UV = corners[gl_VertexID];
+    Pos = mix(rect.xy, rect.zw, UV);
+    gl_Position = projection * vec4(Pos.x, -Pos.y, 0.0, 1.0);
+}
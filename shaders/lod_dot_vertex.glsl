@@ -0,0 +1,21 @@
+#version 330 core
+
+const float INK = 0.25;
+
+layout (location = 0) in vec4 dot; // center x, y, glyph size, digit value
+
+out vec4 DotColor;
+
+uniform mat4 projection;
+uniform float pixelScale;
+
+void main()
+{
+    gl_Position = projection * vec4(dot.x, -dot.y, 0.0, 1.0);
+
+    // Cover as much of the point as the glyph would have inked
+    float px = dot.z * pixelScale;
+    gl_PointSize = max(px, 1.0);
+    float shade = dot.w < 0.0 ? 0.0 : dot.w / 9.0 * 0.5;
+    DotColor = vec4(vec3(shade), clamp(px * px * INK / (gl_PointSize * gl_PointSize), 0.0, 1.0));
+}
@@ -0,0 +1,36 @@
+#version 330 core
+
+const int MAX_GLYPHS = 16;
+const float H_PI = 1.57079632679;
+
+layout (location = 0) in vec3 instance;
+layout (location = 1) in uint glyph;
+
+out vec4 TexCoords;
+
+uniform mat4 projection;
+uniform vec2 center;
+uniform vec2 glyphPos[MAX_GLYPHS * 6];
+uniform vec4 glyphTex[MAX_GLYPHS * 6];
+
+mat2 rotate(float angle)
+{
+    float c = cos(angle), s = sin(angle);
+    return mat2(c, s, -s, c);
+}
+
+void main()
+{
+    int i = int(glyph) * 6 + gl_VertexID;
+    float angle = instance.x;
+    float radii = instance.y;
+    float scale = instance.z;
+
+    vec2 r = glyphPos[i] * rotate(-angle);
+    r *= scale;
+    r += vec2(radii, 0) * rotate(-angle + H_PI);
+    r += center;
+
+    gl_Position = projection * vec4(r.x, -r.y, 0.0, 1.0);
+    TexCoords = glyphTex[i];
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+layout (location = 0) in vec2 vertex;
+layout (location = 1) in vec2 texture;
+layout (location = 2) in vec4 color;
+
+out vec4 TexCoords;
+
+uniform mat4 projection;
+uniform vec4 box;
+
+void main()
+{
+    vec2 pos = box.xy + vertex * box.zw;
+    gl_Position = projection * vec4(pos.x, -pos.y, 0.0, 1.0);
+    // Same vec4 text_vertex.glsl passes on, atlas coords at full precision
+    TexCoords = vec4(texture, color.zw);
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPIRAL_KERNEL_X86
+#endif
+
+// Batch placement of glyph corners on the spiral
+//
+// Each glyph is a structure-of-arrays entry (angle, radii, scale, table slot),
+// corners holds 6 (x, y) pairs per table slot relative to the glyph center.
+// A corner c lands at
+//     scale * (c * rotate(-angle)) + (radii, 0) * rotate(-angle + pi/2) + center
+// which is what ui_circle_text_t::mesh_char did per glyph with glm matricies.
+// Output is 6 verticies per glyph, x at out[(i * 6 + k) * stride] and y right
+// after it, so it can write straight into interleaved vertex arrays.
+namespace spiral_kernel {
+    struct batch_t {
+        const float *angle;
+        const float *radii;
+        const float *scale;
+        const uint32_t *glyph;
+        size_t count;
+    };
+
+    using fn_t = void (*)(const batch_t &b, const float *corners, float cx, float cy, float *out, size_t stride);
+
+    inline void place(const batch_t &b, size_t i, float sa, float ca, const float *corners, float cx, float cy, float *out, size_t stride) {
+        float ox = b.radii[i] * sa + cx;
+        float oy = -b.radii[i] * ca + cy;
+        const float *c = &corners[b.glyph[i] * 12];
+        float *o = &out[i * 6 * stride];
+        for (int k = 0; k < 6; k++, o += stride) {
+            o[0] = b.scale[i] * (c[k * 2] * ca - c[k * 2 + 1] * sa) + ox;
+            o[1] = b.scale[i] * (c[k * 2] * sa + c[k * 2 + 1] * ca) + oy;
+        }
+    }
+
+    inline void scalar(const batch_t &b, const float *corners, float cx, float cy, float *out, size_t stride) {
+        for (size_t i = 0; i < b.count; i++)
+            place(b, i, std::sin(b.angle[i]), std::cos(b.angle[i]), corners, cx, cy, out, stride);
+    }
+
+#ifdef SPIRAL_KERNEL_X86
+    // Cephes style sincosf, pi/2 split in three for the range reduction
+    namespace sincos_consts {
+        constexpr float two_over_pi = 0.636619772367581343f;
+        constexpr float dp1 = 1.5703125f;
+        constexpr float dp2 = 4.837512969970703125e-4f;
+        constexpr float dp3 = 7.54978995489188216e-8f;
+        constexpr float s1 = -1.6666654611e-1f, s2 = 8.3321608736e-3f, s3 = -1.9515295891e-4f;
+        constexpr float c1 = 4.166664568298827e-2f, c2 = -1.388731625493765e-3f, c3 = 2.443315711809948e-5f;
+    }
+
+    __attribute__((target("sse2")))
+    inline void sincos_sse2(__m128 x, __m128 &s, __m128 &c) {
+        using namespace sincos_consts;
+        __m128i j = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(two_over_pi)));
+        __m128 fj = _mm_cvtepi32_ps(j);
+        __m128 y = _mm_sub_ps(x, _mm_mul_ps(fj, _mm_set1_ps(dp1)));
+        y = _mm_sub_ps(y, _mm_mul_ps(fj, _mm_set1_ps(dp2)));
+        y = _mm_sub_ps(y, _mm_mul_ps(fj, _mm_set1_ps(dp3)));
+
+        __m128 z = _mm_mul_ps(y, y);
+        __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(s3), z), _mm_set1_ps(s2));
+        ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(s1));
+        ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), y), y);
+        __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(c3), z), _mm_set1_ps(c2));
+        pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(c1));
+        pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+        pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+        // Quadrant 1 and 3 swap sin and cos, 2 and 3 negate sin, 1 and 2 negate cos
+        __m128i q = _mm_and_si128(j, _mm_set1_epi32(3));
+        __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+        __m128 sign = _mm_set1_ps(-0.0f);
+        __m128 neg_s = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+        __m128 neg_c = _mm_castsi128_ps(_mm_slli_epi32(_mm_xor_si128(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_srli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 1)), 31));
+
+        s = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+        c = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+        s = _mm_xor_ps(s, _mm_and_ps(neg_s, sign));
+        c = _mm_xor_ps(c, _mm_and_ps(neg_c, sign));
+    }
+
+    __attribute__((target("sse2")))
+    inline void sse2(const batch_t &b, const float *corners, float cx, float cy, float *out, size_t stride) {
+        size_t i = 0;
+        alignas(16) float xs[4], ys[4];
+        for (; i + 4 <= b.count; i += 4) {
+            __m128 sa, ca;
+            sincos_sse2(_mm_loadu_ps(&b.angle[i]), sa, ca);
+            __m128 radii = _mm_loadu_ps(&b.radii[i]);
+            __m128 scale = _mm_loadu_ps(&b.scale[i]);
+            __m128 ox = _mm_add_ps(_mm_mul_ps(radii, sa), _mm_set1_ps(cx));
+            __m128 oy = _mm_sub_ps(_mm_set1_ps(cy), _mm_mul_ps(radii, ca));
+
+            const float *c0 = &corners[b.glyph[i] * 12], *c1 = &corners[b.glyph[i + 1] * 12];
+            const float *c2 = &corners[b.glyph[i + 2] * 12], *c3 = &corners[b.glyph[i + 3] * 12];
+
+            for (int k = 0; k < 6; k++) {
+                __m128 px = _mm_set_ps(c3[k * 2], c2[k * 2], c1[k * 2], c0[k * 2]);
+                __m128 py = _mm_set_ps(c3[k * 2 + 1], c2[k * 2 + 1], c1[k * 2 + 1], c0[k * 2 + 1]);
+                __m128 x = _mm_add_ps(_mm_mul_ps(scale, _mm_sub_ps(_mm_mul_ps(px, ca), _mm_mul_ps(py, sa))), ox);
+                __m128 y = _mm_add_ps(_mm_mul_ps(scale, _mm_add_ps(_mm_mul_ps(px, sa), _mm_mul_ps(py, ca))), oy);
+                _mm_store_ps(xs, x);
+                _mm_store_ps(ys, y);
+                for (int l = 0; l < 4; l++) {
+                    float *o = &out[((i + l) * 6 + k) * stride];
+                    o[0] = xs[l];
+                    o[1] = ys[l];
+                }
+            }
+        }
+
+        for (; i < b.count; i++)
+            place(b, i, std::sin(b.angle[i]), std::cos(b.angle[i]), corners, cx, cy, out, stride);
+    }
+
+    __attribute__((target("avx2,fma")))
+    inline void sincos_avx2(__m256 x, __m256 &s, __m256 &c) {
+        using namespace sincos_consts;
+        __m256i j = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(two_over_pi)));
+        __m256 fj = _mm256_cvtepi32_ps(j);
+        __m256 y = _mm256_fnmadd_ps(fj, _mm256_set1_ps(dp1), x);
+        y = _mm256_fnmadd_ps(fj, _mm256_set1_ps(dp2), y);
+        y = _mm256_fnmadd_ps(fj, _mm256_set1_ps(dp3), y);
+
+        __m256 z = _mm256_mul_ps(y, y);
+        __m256 ps = _mm256_fmadd_ps(_mm256_set1_ps(s3), z, _mm256_set1_ps(s2));
+        ps = _mm256_fmadd_ps(ps, z, _mm256_set1_ps(s1));
+        ps = _mm256_fmadd_ps(_mm256_mul_ps(ps, z), y, y);
+        __m256 pc = _mm256_fmadd_ps(_mm256_set1_ps(c3), z, _mm256_set1_ps(c2));
+        pc = _mm256_fmadd_ps(pc, z, _mm256_set1_ps(c1));
+        pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+        pc = _mm256_add_ps(_mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), pc), _mm256_set1_ps(1.0f));
+
+        __m256i q = _mm256_and_si256(j, _mm256_set1_epi32(3));
+        __m256i odd = _mm256_and_si256(q, _mm256_set1_epi32(1));
+        __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(odd, _mm256_set1_epi32(1)));
+        __m256 neg_s = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+        __m256 neg_c = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_xor_si256(odd, _mm256_srli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 1)), 31));
+
+        s = _mm256_blendv_ps(ps, pc, swap);
+        c = _mm256_blendv_ps(pc, ps, swap);
+        s = _mm256_xor_ps(s, neg_s);
+        c = _mm256_xor_ps(c, neg_c);
+    }
+
+    __attribute__((target("avx2,fma")))
+    inline void avx2(const batch_t &b, const float *corners, float cx, float cy, float *out, size_t stride) {
+        size_t i = 0;
+        alignas(32) float xs[8], ys[8];
+        for (; i + 8 <= b.count; i += 8) {
+            __m256 sa, ca;
+            sincos_avx2(_mm256_loadu_ps(&b.angle[i]), sa, ca);
+            __m256 radii = _mm256_loadu_ps(&b.radii[i]);
+            __m256 scale = _mm256_loadu_ps(&b.scale[i]);
+            __m256 ox = _mm256_fmadd_ps(radii, sa, _mm256_set1_ps(cx));
+            __m256 oy = _mm256_fnmadd_ps(radii, ca, _mm256_set1_ps(cy));
+
+            // Corner k of every lane's glyph, x and y interleaved in the table
+            __m256i base = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)&b.glyph[i]), _mm256_set1_epi32(12));
+
+            for (int k = 0; k < 6; k++) {
+                __m256i idx = _mm256_add_epi32(base, _mm256_set1_epi32(k * 2));
+                __m256 px = _mm256_i32gather_ps(corners, idx, 4);
+                __m256 py = _mm256_i32gather_ps(corners + 1, idx, 4);
+                __m256 x = _mm256_fmadd_ps(scale, _mm256_fmsub_ps(px, ca, _mm256_mul_ps(py, sa)), ox);
+                __m256 y = _mm256_fmadd_ps(scale, _mm256_fmadd_ps(px, sa, _mm256_mul_ps(py, ca)), oy);
+                _mm256_store_ps(xs, x);
+                _mm256_store_ps(ys, y);
+                for (int l = 0; l < 8; l++) {
+                    float *o = &out[((i + l) * 6 + k) * stride];
+                    o[0] = xs[l];
+                    o[1] = ys[l];
+                }
+            }
+        }
+
+        for (; i < b.count; i++)
+            place(b, i, std::sin(b.angle[i]), std::cos(b.angle[i]), corners, cx, cy, out, stride);
+    }
+#endif
+
+    struct variant_t {
+        const char *name;
+        fn_t fn;
+    };
+
+    // Every variant this cpu can run, best last
+    inline int variants(variant_t *out) {
+        int n = 0;
+        out[n++] = {"scalar", scalar};
+#ifdef SPIRAL_KERNEL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2"))
+            out[n++] = {"sse2", sse2};
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            out[n++] = {"avx2", avx2};
+#endif
+        return n;
+    }
+
+    inline variant_t best() {
+        static variant_t chosen = []{
+            variant_t v[4];
+            return v[variants(v) - 1];
+        }();
+        return chosen;
+    }
+}
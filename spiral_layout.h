@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cmath>
+#include <map>
+
+constexpr float H_PI = 0.5f * M_PI;
+constexpr float D_PI = 2.0f * M_PI;
+
+// Layout inputs of the circle text spiral
+struct spiral_layout_t {
+    float base_dist, base_center_dist, base_angle, char_scale, radii_scale_1, radii_scale_2;
+    bool reverse_dir;
+
+    bool operator==(const spiral_layout_t &) const = default;
+    auto operator<=>(const spiral_layout_t &) const = default;
+
+    float radii_at(float angle) const {
+        return ((angle / D_PI) * base_dist + base_center_dist) * radii_scale_2;
+    }
+
+    float second_scale_at(float angle) const {
+        float radii = radii_at(angle);
+        return std::abs(std::pow(radii, radii_scale_1) - radii + 1);
+    }
+
+    // Angle step from a character at angle to the next one
+    float step_at(float angle) const {
+        float radii = radii_at(angle);
+        float second_scale = std::abs(std::pow(radii, radii_scale_1) - radii + 1);
+        float char_angle = std::atan(base_dist / radii);
+        return char_angle * second_scale;
+    }
+};
+
+// Shrinks a reverse_dir layout until count characters fit inside fit_radii
+//
+// The fit steps every parameter down by a fixed amount until the outermost
+// character is inside fit_radii or the distance and radii scale limits are
+// reached. Instead of walking all characters once per step, the step count
+// is found by bisection and results are memoized per count and input layout.
+struct spiral_fit_t {
+    static constexpr float fit_radii = 1.4;
+    static constexpr float dist_limit = 0.016;
+    static constexpr float radii_scale_limit = 1.78;
+    static constexpr float arb = 500.0;
+    static constexpr int max_steps = 100000;
+    static constexpr size_t max_cache = 4096;
+
+    struct result_t {
+        spiral_layout_t layout;
+        float start; // angle of the first character
+        float angle; // angle of the last character
+        int steps;
+    };
+
+    static bool converged(const spiral_layout_t &l) {
+        return l.base_dist < dist_limit && l.radii_scale_2 <= radii_scale_limit;
+    }
+
+    // Apply one fitting step
+    static void step(spiral_layout_t &l) {
+        l.char_scale -= (0.1/arb);
+        if (l.base_dist > dist_limit)
+            l.base_dist -= (0.015/arb);
+        l.radii_scale_1 -= (0.4/arb);
+        if (l.radii_scale_2 > radii_scale_limit)
+            l.radii_scale_2 -= (0.20/arb);
+    }
+
+    static spiral_layout_t stepped(spiral_layout_t l, int steps) {
+        for (int i = 0; i < steps; i++)
+            step(l);
+        return l;
+    }
+
+    // Walk count characters from angle, returns the end angle and the largest radii seen
+    static float walk(const spiral_layout_t &l, int count, float angle, float &max_radii) {
+        max_radii = 0;
+        for (int i = 1; i < count; i++) {
+            float radii = l.radii_at(angle);
+            if (radii > max_radii)
+                max_radii = radii;
+            angle += l.step_at(angle);
+        }
+        return angle;
+    }
+
+    result_t fit(const spiral_layout_t &in, int count) {
+        auto key = std::make_pair(count, in);
+        auto it = cache.find(key);
+        if (it != cache.end())
+            return it->second;
+
+        result_t res = solve(in, count);
+
+        if (cache.size() >= max_cache)
+            cache.clear();
+        cache.emplace(key, res);
+
+        return res;
+    }
+
+    static result_t solve(const spiral_layout_t &in, int count) {
+        float max_radii;
+
+        // The first pass starts at base_angle, refits restart at 0
+        float angle = walk(in, count, in.base_angle, max_radii);
+        if (max_radii < fit_radii || converged(in))
+            return {in, in.base_angle, angle, 0};
+
+        // Steps until the limits stop the fit regardless of size
+        int hi = 1;
+        spiral_layout_t l = in;
+        for (step(l); !converged(l) && hi < max_steps; step(l))
+            hi++;
+
+        // Past convergence nothing fits any better, so try hi before bisecting
+        angle = walk(l, count, 0, max_radii);
+        if (max_radii >= fit_radii)
+            return {l, 0, angle, hi};
+
+        // Smallest step count that fits, the radii shrinks with every step
+        int lo = 1;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            walk(stepped(in, mid), count, 0, max_radii);
+            if (max_radii < fit_radii)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+
+        l = stepped(in, lo);
+        angle = walk(l, count, 0, max_radii);
+
+        return {l, 0, angle, lo};
+    }
+
+    std::map<std::pair<int, spiral_layout_t>, result_t> cache;
+};
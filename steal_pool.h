@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs job(i, worker) for every i in [0, count) on a pool of threads
+//
+// Each thread starts on an equal slice of the indices and takes them one at
+// a time from the front. A thread that runs dry steals the back half of the
+// fullest slice it can find, so jobs of very different cost still keep every
+// core busy to the end.
+struct steal_pool_t {
+    using job_t = std::function<void(size_t, unsigned)>;
+
+    steal_pool_t(unsigned threads = std::thread::hardware_concurrency())
+    :threads(std::max(threads, 1u)) {}
+
+    // Blocks until every job is done
+    void run(size_t count, job_t job) {
+        slices.clear();
+        for (unsigned w = 0; w < threads; w++) {
+            slices.push_back(std::make_unique<slice_t>());
+            slices.back()->lo = count * w / threads;
+            slices.back()->hi = count * (w + 1) / threads;
+        }
+
+        std::vector<std::thread> workers;
+        for (unsigned w = 0; w < threads; w++)
+            workers.emplace_back(&steal_pool_t::work, this, w, std::ref(job));
+        for (auto &t : workers)
+            t.join();
+    }
+
+    unsigned threads;
+    std::atomic<size_t> steals = 0;
+
+    protected:
+    struct slice_t {
+        std::mutex mutex;
+        size_t lo = 0, hi = 0;
+    };
+
+    void work(unsigned w, const job_t &job) {
+        slice_t &own = *slices[w];
+        while (true) {
+            size_t i;
+            {
+                std::lock_guard lock(own.mutex);
+                i = own.lo < own.hi ? own.lo++ : SIZE_MAX;
+            }
+            if (i != SIZE_MAX) {
+                job(i, w);
+                continue;
+            }
+            if (!steal(w))
+                return;
+        }
+    }
+
+    // Move the back half of the fullest other slice into w's, false once there's nothing left
+    //
+    // Work never grows, so an empty pass means the rest is already being run.
+    bool steal(unsigned w) {
+        while (true) {
+            unsigned victim = w;
+            size_t most = 0;
+            for (unsigned v = 0; v < threads; v++) {
+                if (v == w)
+                    continue;
+                std::lock_guard lock(slices[v]->mutex);
+                if (slices[v]->hi - slices[v]->lo > most) {
+                    most = slices[v]->hi - slices[v]->lo;
+                    victim = v;
+                }
+            }
+            if (victim == w)
+                return false;
+
+            size_t lo, hi;
+            {
+                std::lock_guard lock(slices[victim]->mutex);
+                size_t left = slices[victim]->hi - slices[victim]->lo;
+                // Someone else got there first, look again
+                if (left == 0)
+                    continue;
+                hi = slices[victim]->hi;
+                lo = hi - (left + 1) / 2;
+                slices[victim]->hi = lo;
+            }
+
+            std::lock_guard lock(slices[w]->mutex);
+            slices[w]->lo = lo;
+            slices[w]->hi = hi;
+            steals++;
+            return true;
+        }
+    }
+
+    std::vector<std::unique_ptr<slice_t>> slices;
+};
@@ -0,0 +1,180 @@
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "texture.h"
+#include "text.h"
+#include "ui_element.h"
+#include "ui_text.h"
+#include "shader_program.h"
+#include "shader.h"
+#include "../circle_text.h"
+#include "../headless.h"
+#include "lcg_source.h"
+
+// Checks that appending digits to a mesh gives the same glyphs as a rebuild
+//
+// One spiral grows by uneven steps with appends, a second one is rebuilt
+// from scratch at every size, for both the vertex and the instanced path and
+// both directions. Both refit at the same sizes, so their layouts stay equal.
+// A string replaced by a longer one has to match one set from the start,
+// and an instanced one with too many distinct characters has to fall back
+// to the same quads.
+// Instances have to match exactly. Verticies go through spiral_kernel, where
+// a glyph can land in a SIMD lane in one mesh and the scalar tail in the
+// other, so they only have to agree to within max_error.
+//
+//   ./append_test (from the repo root, it loads assets/text.png)
+
+namespace append_test {
+    const size_t max_digits = 30000;
+    const float max_error = 1e-5;
+
+    texture_t *text_texture;
+
+    ui_circle_text_t *create(bool instanced, bool reverse, bool incremental) {
+        auto *c = new ui_circle_text_t(window, nullptr, text_texture, {-1.0,-1.0,1.0,1.0});
+        c->instanced = instanced;
+        c->reverse_dir = reverse;
+        c->incremental = incremental;
+        c->async = false;
+        c->load();
+        return c;
+    }
+
+    // Largest difference between the two meshes, INFINITY if they don't even line up
+    float compare(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b, bool instanced) {
+        if (a.size() != b.size())
+            return INFINITY;
+        if (instanced)
+            return memcmp(a.data(), b.data(), a.size()) ? INFINITY : 0;
+
+        const float *fa = (const float*)a.data(), *fb = (const float*)b.data();
+        float worst = 0;
+        for (size_t i = 0; i < a.size() / sizeof(float); i++)
+            worst = std::max(worst, std::abs(fa[i] - fb[i]));
+        return worst;
+    }
+
+    int run(bool instanced, bool reverse) {
+        lcg_source_t source(max_digits);
+        ui_circle_text_t *grown = create(instanced, reverse, true);
+        ui_circle_text_t *rebuilt = create(instanced, reverse, false);
+
+        int failed = 0;
+        size_t steps = 0;
+        grown->set_source(&source, 1);
+        for (size_t n = 1, step = 1; n <= max_digits; n += step, step = step * 3 / 2 + 1) {
+            grown->show(n);
+            grown->mesh();
+            rebuilt->set_source(&source, n);
+            rebuilt->mesh();
+            steps++;
+
+            float error = compare(grown->read_back(), rebuilt->read_back(), instanced);
+            if (error > max_error) {
+                fprintf(stderr, "%s%s at %zu digits: append differs from a rebuild by %g\n",
+                        instanced ? "instanced" : "verticies", reverse ? " reverse_dir" : "", n, error);
+                failed++;
+            }
+        }
+
+        printf("%s%s: %zu sizes, %i failed\n", instanced ? "instanced" : "verticies", reverse ? " reverse_dir" : "", steps, failed);
+        delete grown;
+        delete rebuilt;
+        return failed;
+    }
+
+    // A longer string in place of the old one has to be meshed whole, not appended to it
+    int run_replace(bool instanced) {
+        ui_circle_text_t *replaced = create(instanced, false, true);
+        ui_circle_text_t *fresh = create(instanced, false, false);
+
+        replaced->set_string("3.1415926535");
+        replaced->mesh();
+        replaced->set_string("2.718281828459045");
+        replaced->mesh();
+        fresh->set_string("2.718281828459045");
+        fresh->mesh();
+
+        int failed = compare(replaced->read_back(), fresh->read_back(), instanced) > max_error;
+        printf("%s set_string: %i failed\n", instanced ? "instanced" : "verticies", failed);
+        delete replaced;
+        delete fresh;
+        return failed;
+    }
+
+    // Past max_glyphs distinct characters the instanced path has to fall back to quads
+    int run_overflow() {
+        const std::string str = "3.14159265358979 abcdefghij";
+        ui_circle_text_t *grown = create(true, false, true);
+        ui_circle_text_t *quads = create(false, false, false);
+
+        for (char ch : str) {
+            grown->add_char(ch);
+            grown->mesh();
+        }
+        quads->set_string(str);
+        quads->mesh();
+
+        int failed = compare(grown->read_back(), quads->read_back(), false) > max_error;
+        printf("instanced overflow: %i failed\n", failed);
+        delete grown;
+        delete quads;
+        return failed;
+    }
+}
+
+int main(int argc, char **argv) {
+    headless_init_hints();
+    if (!glfwInit())
+        handle_error("Failed to init glfw");
+
+    headless_window_hints();
+    window = glfwCreateWindow(64, 64, "Pi Day 2025 append test", 0, 0);
+    if (!window)
+        handle_error("Failed to create glfw window");
+    glfwMakeContextCurrent(window);
+
+    append_test::text_texture = new texture_t;
+    if (append_test::text_texture->load("assets/text.png"))
+        handle_error("Failed to load assets");
+
+    int failed = 0;
+    for (bool instanced : {false, true})
+        for (bool reverse : {true, false})
+            failed += append_test::run(instanced, reverse);
+    for (bool instanced : {false, true})
+        failed += append_test::run_replace(instanced);
+    failed += append_test::run_overflow();
+
+    safe_exit(failed != 0);
+}
+
+void handle_signal(int signal) {
+    safe_exit(1);
+}
+
+void reset() {
+
+}
+
+void destroy() {
+    glfwTerminate();
+}
+
+void safe_exit(int errcode) {
+    destroy();
+    exit(errcode);
+}
+
+void handle_error(const char *errstr, int errcode) {
+    fprintf(stderr, "Error: %s\n", errstr);
+    safe_exit(errcode);
+}
+
+void hint_exit() {
+    glfwSetWindowShouldClose(window, 1);
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "../bigpi.h"
+
+// Checks bigpi::compute(n) against known digits for a sweep of n
+//
+// pi_10000.txt is "3." and the first 10000 decimals. Every n up to 200 is
+// checked, then a stride through the rest plus sizes that used to come out
+// wrong, on one thread and on several.
+//
+//   ./bigpi_test [tests/pi_10000.txt]
+
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : "tests/pi_10000.txt";
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Error: failed to open %s\n", path);
+        return 1;
+    }
+    std::string known;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof buf, f)) > 0)
+        known.append(buf, n);
+    fclose(f);
+
+    size_t max = known.size() - 2;
+    std::vector<size_t> sizes;
+    for (size_t i = 1; i <= 200; i++)
+        sizes.push_back(i);
+    for (size_t i = 201; i <= max; i += 97)
+        sizes.push_back(i);
+    for (size_t i : {1660, 2374, 3935, 4397, 4586, 4922, 5594, 5918, 7955})
+        sizes.push_back(i);
+    sizes.push_back(max);
+
+    int failed = 0;
+    for (int threads : {1, 4}) {
+        for (size_t digits : sizes) {
+            std::string pi = bigpi::compute(digits, threads);
+            if (pi == known.substr(0, digits + 2))
+                continue;
+            size_t at = 0;
+            while (at < pi.size() && at < known.size() && pi[at] == known[at])
+                at++;
+            fprintf(stderr, "compute(%zu) on %i threads: wrong from character %zu\n", digits, threads, at);
+            failed++;
+        }
+    }
+
+    // A set stop has to get out of the computation instead of finishing it
+    std::atomic<bool> stop = true;
+    try {
+        bigpi::compute(100000, 1, &stop);
+        fprintf(stderr, "compute() ignored stop\n");
+        failed++;
+    } catch (const bigpi::cancelled_t &) {
+    }
+
+    printf("%zu sizes, %i failed\n", sizes.size() * 2, failed);
+    return failed != 0;
+}
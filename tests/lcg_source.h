@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "../digit_source.h"
+
+// Deterministic stand in for the pi digits, "3." and then count - 2 LCG digits
+//
+// Shared by bench.cpp and the tests, neither cares which digits they are.
+struct lcg_source_t : public digit_source_t {
+    std::string chars;
+
+    lcg_source_t(size_t count) {
+        chars.reserve(count);
+        chars = "3.";
+        uint32_t x = 314159;
+        while (chars.size() < count) {
+            x = x * 1664525 + 1013904223;
+            chars += '0' + (x >> 16) % 10;
+        }
+        chars.resize(count);
+    }
+
+    size_t size() const override { return chars.size(); }
+    char at(size_t i) const override { return chars[i]; }
+};
@@ -0,0 +1,80 @@
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../spiral_kernel.h"
+#include "../spiral_layout.h"
+
+// Checks every spiral_kernel variant against the glm transform and times them
+//
+// A million glyphs along a fitted spiral go through the per glyph matricies
+// ui_circle_text_t::mesh_char used, then through each variant this CPU can
+// run. Every corner has to be within tolerance of the glm one.
+//
+//   ./spiral_kernel_test
+
+int main() {
+    const size_t count = 1000000;
+    const float tolerance = 1e-4;
+
+    spiral_layout_t l = {0.016, 0.178, 0, 0.95, 0.38, 1.78, false};
+    std::vector<float> angles(count), radii(count), scales(count), corners(12 * 12);
+    std::vector<uint32_t> slots(count);
+
+    float angle = 0;
+    for (size_t i = 0; i < count; i++) {
+        angles[i] = angle;
+        radii[i] = l.radii_at(angle);
+        scales[i] = sqrt(2.0f) * l.char_scale * l.second_scale_at(angle);
+        slots[i] = i % 12;
+        angle += l.step_at(angle);
+    }
+    for (size_t i = 0; i < corners.size(); i++)
+        corners[i] = ((i * 7919) % 100) * 0.0002f - 0.01f;
+
+    glm::vec2 center_pos(0.25f, -0.5f);
+    std::vector<glm::vec2> expect(count * 6);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        glm::mat4 m1 = glm::rotate(glm::mat4(1.0), -angles[i], glm::vec3(0,0,1.0));
+        glm::mat4 m2 = glm::rotate(glm::mat4(1.0), -angles[i] + H_PI, glm::vec3(0,0,1.0));
+        for (int k = 0; k < 6; k++) {
+            glm::vec2 r(corners[slots[i] * 12 + k * 2], corners[slots[i] * 12 + k * 2 + 1]);
+            r = r * glm::mat2(m1);
+            r *= scales[i];
+            r += glm::vec2(radii[i], 0) * glm::mat2(m2);
+            r += center_pos;
+            expect[i * 6 + k] = r;
+        }
+    }
+    double glm_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-8s %12.0f glyphs/s\n", "glm", count / glm_time);
+
+    spiral_kernel::variant_t variants[4];
+    int n = spiral_kernel::variants(variants);
+    int failed = 0;
+    std::vector<glm::vec2> got(count * 6);
+
+    for (int v = 0; v < n; v++) {
+        start = std::chrono::steady_clock::now();
+        variants[v].fn({angles.data(), radii.data(), scales.data(), slots.data(), count}, corners.data(), center_pos[0], center_pos[1], &got[0][0], 2);
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        float error = 0;
+        for (size_t i = 0; i < got.size(); i++)
+            error = std::max(error, std::max(std::abs(got[i][0] - expect[i][0]), std::abs(got[i][1] - expect[i][1])));
+
+        bool ok = error <= tolerance;
+        failed += !ok;
+        printf("%-8s %12.0f glyphs/s  max error %g %s\n", variants[v].name, count / time, error, ok ? "ok" : "FAILED");
+    }
+
+    printf("using %s, %i variants, %i failed\n", spiral_kernel::best().name, n, failed);
+    return failed != 0;
+}